@@ -16,11 +16,41 @@ async function api(url, method = 'GET', body = null) {
     return json;
 }
 
+// Aplica um delta do GET_SINCE a uma coleção (atualiza no lugar, novos no fim)
+function applyDelta(list, delta, key) {
+    const changed = new Map(delta.updated.map(e => [e[key], e]));
+    const deleted = new Set(delta.deleted);
+    return list
+        .filter(e => !deleted.has(e[key]))
+        .map(e => changed.get(e[key]) || e)
+        .concat(delta.inserted);
+}
+
 async function syncData() {
     try {
-        const data = await api('/api/data');
+        // Depois da primeira carga pede só o que mudou desde a última revisão
+        const data = state.rev === undefined
+            ? await api('/api/data')
+            : await api(`/api/since?rev=${state.rev}&epoca=${state.epoca}`);
         if (data.error) throw new Error(data.error);
-        state = data;
+        if (state.rev === undefined || data.full) {
+            state = data;
+        } else {
+            state = {
+                rev: data.rev,
+                epoca: data.epoca,
+                catalog: applyDelta(state.catalog, data.catalog, 'id'),
+                inventory: applyDelta(state.inventory, data.inventory, 'id_ingrediente'),
+                recipes: applyDelta(state.recipes, data.recipes, 'id'),
+                orders: applyDelta(state.orders, data.orders, 'id_pedido'),
+                proximo_pedido: data.proximo_pedido,
+            };
+        }
+        // Mesma ordem do C: prioridade maior primeiro, chegada dentro do nível
+        state.orders.sort((a, b) => (b.prioridade - a.prioridade) || (a.id_pedido - b.id_pedido));
+        // Porções produzíveis por receita (cache no C, barato mesmo com muitas receitas)
+        const prod = await api('/api/recipes/can-make');
+        state.porcoes = new Map((prod.receitas || []).map(p => [p.id_receita, p.porcoes]));
         setSyncStatus(true);
     } catch (e) {
         setSyncStatus(false);
@@ -172,7 +202,7 @@ function renderInventory() {
         return `<tr>
             <td><span class="badge badge-blue">#${item.id_ingrediente}</span></td>
             <td><strong>${name}</strong></td>
-            <td>${item.quantity.toFixed(2)} ${unit}</td>
+            <td>${item.quantity.toFixed(2)} ${unit}${item.reserved ? ` <span class="badge badge-amber" title="Reservado por pedidos na fila">${item.reserved.toFixed(2)} reservado</span>` : ''}</td>
             <td style="text-align:right;white-space:nowrap">
                 <button class="btn btn-outline btn-sm" onclick="modalAddStock(${item.id_ingrediente})">+ Entrada</button>
                 <button class="btn btn-danger btn-sm" onclick="delStock(${item.id_ingrediente},'${esc(name)}')">🗑</button>
@@ -248,10 +278,12 @@ function renderRecipes() {
                 <span style="color:var(--text-dim)">${ing.qtd.toFixed(2)} ${catUnit(ing.id)}</span>
             </div>`).join('');
         const hasPedidos = state.orders.some(o => o.id_receita === r.id);
+        const porcoes = state.porcoes ? state.porcoes.get(r.id) : undefined;
         return `
         <div class="card fade-in">
             <div class="card-header">
-                <div><h2>${r.name}</h2><span class="badge badge-blue" style="margin-top:4px">ID #${r.id}</span></div>
+                <div><h2>${r.name}</h2><span class="badge badge-blue" style="margin-top:4px">ID #${r.id}</span>
+                    ${porcoes !== undefined ? `<span class="badge ${porcoes > 0 ? 'badge-green' : 'badge-red'}" style="margin-top:4px" title="Porções possíveis com o estoque atual">Dá para ${porcoes}</span>` : ''}</div>
                 <div style="display:flex;gap:8px;flex-wrap:wrap;align-items:center">
                     <button class="btn btn-outline btn-sm" onclick="modalIngredient(${r.id})">+ Ingrediente</button>
                     <button class="btn btn-success btn-sm" onclick="addOrder(${r.id})">🛒 Pedir</button>
@@ -325,26 +357,30 @@ async function addIngredient(id_rec) {
 
 // ── FILA DE PEDIDOS ───────────────────────────────────────────────────────────
 function renderOrders() {
-    const items = state.orders.map((o, i) => `
+    const items = state.orders.map((o, i) => {
+        const prox = o.id_pedido === state.proximo_pedido;
+        return `
         <div class="queue-item fade-in">
             <div class="queue-item-info">
-                <strong>${i === 0 ? '🔜 ' : ''}${o.nome_receita}</strong>
-                <span>Pedido #${o.id_pedido} · ${i === 0 ? 'Próximo' : 'Posição ' + (i + 1)}</span>
+                <strong>${prox ? '🔜 ' : ''}${o.nome_receita}</strong>
+                <span>Pedido #${o.id_pedido} · ${prox ? 'Próximo' : 'Posição ' + (i + 1)} · ${PRIORIDADES[o.prioridade] || ''}</span>
             </div>
             <div style="display:flex;gap:8px;align-items:center">
-                <span class="badge ${i === 0 ? 'badge-green' : 'badge-blue'}">${i === 0 ? 'PRÓXIMO' : 'FILA'}</span>
+                <span class="badge ${prox ? 'badge-green' : 'badge-blue'}">${prox ? 'PRÓXIMO' : 'FILA'}</span>
                 <button class="btn btn-danger btn-sm" onclick="delOrder(${o.id_pedido})">✕</button>
             </div>
-        </div>`).join('');
+        </div>`;
+    }).join('');
 
     document.getElementById('main-content').innerHTML = `
-        <header class="fade-in"><h1>Fila de Pedidos</h1><p>Estrutura FIFO — primeiro a entrar, primeiro a sair.</p></header>
+        <header class="fade-in"><h1>Fila de Pedidos</h1><p>Fila com prioridade — FIFO dentro de cada nível, com envelhecimento.</p></header>
         <div class="card fade-in">
             <div class="card-header">
                 <h2>${state.orders.length} pedido(s)</h2>
                 <div style="display:flex;gap:8px">
                     <button class="btn btn-outline" onclick="modalOrder()">+ Novo Pedido</button>
                     <button class="btn btn-success" onclick="processOrder()" ${!state.orders.length ? 'disabled' : ''}>🍳 Processar Próximo</button>
+                    <button class="btn btn-success" onclick="processAllOrders()" ${!state.orders.length ? 'disabled' : ''}>🍳 Processar Todos</button>
                 </div>
             </div>
             <div class="card-body">
@@ -355,12 +391,17 @@ function renderOrders() {
         </div>`;
 }
 
+const PRIORIDADES = ['Baixa', 'Normal', 'Alta'];
+
 function modalOrder() {
     if (!state.recipes.length) return toast('Cadastre receitas primeiro.', 'error');
     const opts = state.recipes.map(r => `<option value="${r.id}">${r.name}</option>`).join('');
     openModal(`
         <div class="modal-title">Novo Pedido</div>
         <div class="form-group"><label>Receita</label><select id="m-rec">${opts}</select></div>
+        <div class="form-group"><label>Prioridade</label><select id="m-prio">
+            ${PRIORIDADES.map((p, i) => `<option value="${i}" ${i === 1 ? 'selected' : ''}>${p}</option>`).join('')}
+        </select></div>
         <div class="modal-actions">
             <button class="btn btn-outline" onclick="closeModal()">Cancelar</button>
             <button class="btn btn-primary" onclick="submitNewOrder()">Enfileirar</button>
@@ -369,11 +410,12 @@ function modalOrder() {
 
 async function submitNewOrder() {
     const id = parseInt(document.getElementById('m-rec').value);
-    await addOrder(id);
+    const prioridade = parseInt(document.getElementById('m-prio').value);
+    await addOrder(id, prioridade);
 }
 
-async function addOrder(id) {
-    const r = await api('/api/order', 'POST', { id });
+async function addOrder(id, prioridade = 1) {
+    const r = await api('/api/order', 'POST', { id, prioridade });
     if (r.ok) {
         closeModal(); await syncData();
         toast('✅ Pedido adicionado à fila! Estoque será verificado ao processar.');
@@ -385,14 +427,19 @@ async function addOrder(id) {
 
 async function processOrder() {
     if (!state.orders.length) return toast('Fila vazia!', 'error');
-    const nome = state.orders[0].nome_receita;
+    const pedidos = state.orders;
     const r = await api('/api/order/process', 'POST');
+    // Com --pular-bloqueados o atendido pode não ser o primeiro da fila
+    const idAtendido = r.id_pedido || state.proximo_pedido;
+    const prox = pedidos.find(o => o.id_pedido === idAtendido) || pedidos[0];
+    const nome = prox.nome_receita;
     await syncData();
+    if (r.pulados && r.pulados.length) toast(`⏭️ Aguardando estoque: #${r.pulados.join(', #')}`, 'error', 5000);
 
     if (r.pilha_ops && r.pilha_ops.length > 0) {
         showPilhaLog(nome, r.ok, r.pilha_ops, r.rollback, r.error, r.falhou);
-    } else if (r.rollback) {
-        showPilhaLog(nome, false, [], true, r.error, r.falhou);
+    } else if (r.rollback || r.falhou) {
+        showPilhaLog(nome, false, [], !!r.rollback, r.error, r.falhou);
     } else if (r.ok) {
         toast(`✅ "${nome}" concluído!`);
     } else {
@@ -400,11 +447,28 @@ async function processOrder() {
     }
 }
 
+// Esvazia a fila numa chamada só; para no primeiro pedido sem estoque
+async function processAllOrders() {
+    if (!state.orders.length) return toast('Fila vazia!', 'error');
+    const r = await api('/api/order/process/batch', 'POST', { n: 'ALL' });
+    await syncData();
+    if (!r.ok) return toast('❌ ' + (r.error || 'Erro'), 'error');
+
+    let msg = `✅ ${r.processados} pedido(s) processado(s).`;
+    if (r.descartados) msg += ` ${r.descartados} descartado(s).`;
+    if (r.estacionados) msg += ` ${r.estacionados} aguardando estoque.`;
+    if (r.bloqueado) {
+        const ultimo = r.pedidos.filter(p => !p.ok).pop();
+        if (ultimo) msg += `<br>⛔ Pedido #${ultimo.id_pedido} parado: ${ultimo.error}`;
+    }
+    toast(msg, r.bloqueado ? 'error' : 'success', 6000);
+}
+
 function showPilhaLog(nome, sucesso, ops, rollback, errorMsg, falhou) {
     const pushOps = ops.filter(o => o.op === 'PUSH');
     const popOps = ops.filter(o => o.op === 'POP_ROLLBACK');
 
-    let html = `<div class="modal-title">${sucesso ? '✅ Pedido Processado' : '❌ Falha — Rollback'}</div>`;
+    let html = `<div class="modal-title">${sucesso ? '✅ Pedido Processado' : rollback ? '❌ Falha — Rollback' : '❌ Falha — Estoque insuficiente'}</div>`;
     html += `<p style="margin-bottom:1rem;font-size:0.9rem;color:var(--text-dim)">Receita: <strong>${nome}</strong></p>`;
 
     if (pushOps.length > 0) {
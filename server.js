@@ -4,6 +4,11 @@
  * Arquitetura:
  *   Browser → HTTP → Node.js → stdin → cozinha_api.exe (C)
  *                                     ← stdout (JSON) ←
+ *
+ * Protocolo com o C (variável de ambiente COZINHA_PROTOCOLO):
+ *   texto  (padrão) — uma linha por comando, um comando por vez (cmdQueue).
+ *   framed          — frames [id u32][tamanho u32][payload]; vários comandos
+ *                     em voo, respostas casadas pelo id.
  */
 
 const http = require('http');
@@ -18,33 +23,59 @@ const WEB_DIR = path.join(__dirname, 'interface_web');
 const IS_WINDOWS = process.platform === 'win32';
 const API_EXE = path.join(__dirname, IS_WINDOWS ? 'cozinha_api.exe' : 'cozinha_api');
 
+const FRAMED = process.env.COZINHA_PROTOCOLO === 'framed';
+// COZINHA_RESERVAS=1: pedidos reservam o estoque ao entrar na fila
+const RESERVAS = process.env.COZINHA_RESERVAS === '1';
+// COZINHA_PULAR_BLOQUEADOS=1: pedido sem estoque não trava os de trás
+const PULAR_BLOQUEADOS = process.env.COZINHA_PULAR_BLOQUEADOS === '1';
+// COZINHA_DUAS_FASES=1: confere o estoque antes de baixar (falha sem rollback)
+const DUAS_FASES = process.env.COZINHA_DUAS_FASES === '1';
+// Separador dos campos de texto (nome|unidade): 0x1F no modo framed,
+// assim nomes com '|' não quebram o comando
+const SEP = FRAMED ? '\x1f' : '|';
+// Comandos aceitos dentro de /api/batch: as mesmas operações que a interface
+// faz uma a uma. Carga/exportação de snapshots, entrada em lote e BATCH
+// aninhado ficam de fora (não podem ser disparados por HTTP).
+const BATCH_PERMITIDOS = new Set([
+    'ADD_CATALOGO', 'DEL_CATALOGO', 'ADD_ESTOQUE', 'DEL_ESTOQUE',
+    'ADD_RECEITA', 'DEL_RECEITA', 'ADD_ING_RECEITA',
+    'ADD_PEDIDO', 'DEL_PEDIDO', 'PROCESSAR_PEDIDO'
+]);
+// Os comandos do /api/batch chegam sempre na forma do modo texto
+// ("ADD_CATALOGO nome|unidade"); estes têm campos de texto, e o primeiro '|'
+// vira o separador do protocolo em uso (SEP), como nas rotas avulsas
+const BATCH_COM_TEXTO = new Set(['ADD_CATALOGO', 'ADD_RECEITA']);
+
+function comandoDoLote(c) {
+    const linha = c.trim();
+    const nome = linha.split(/\s+/)[0];
+    if (!BATCH_COM_TEXTO.has(nome) || SEP === '|') return linha;
+    const i = linha.indexOf('|');
+    return i < 0 ? linha : linha.slice(0, i) + SEP + linha.slice(i + 1);
+}
+
 // ─── Spawn do processo C ──────────────────────────────────────────────────────
 let cProcess = null;
 let responseBuffer = '';
 let pendingResolve = null;
 
 function startCProcess() {
-    cProcess = spawn(API_EXE, [], {
+    const args = [];
+    if (FRAMED) args.push('--framed');
+    if (RESERVAS) args.push('--reservas');
+    if (PULAR_BLOQUEADOS) args.push('--pular-bloqueados');
+    if (DUAS_FASES) args.push('--duas-fases');
+    cProcess = spawn(API_EXE, args, {
         cwd: __dirname,
         stdio: ['pipe', 'pipe', 'pipe']
     });
 
-    cProcess.stdout.setEncoding('utf8');
-
-    cProcess.stdout.on('data', (chunk) => {
-        responseBuffer += chunk;
-        // Pode vir múltiplas linhas de uma vez, ou parcial
-        let newlineIdx;
-        while ((newlineIdx = responseBuffer.indexOf('\n')) !== -1) {
-            const line = responseBuffer.slice(0, newlineIdx).trim();
-            responseBuffer = responseBuffer.slice(newlineIdx + 1);
-            if (line && pendingResolve) {
-                const resolve = pendingResolve;
-                pendingResolve = null;
-                resolve(line);
-            }
-        }
-    });
+    if (FRAMED) {
+        cProcess.stdout.on('data', onFramedData);
+    } else {
+        cProcess.stdout.setEncoding('utf8');
+        cProcess.stdout.on('data', onTextData);
+    }
 
     cProcess.stderr.on('data', (d) => {
         // Mensagens de debug internas do C — logging só aqui
@@ -59,17 +90,34 @@ function startCProcess() {
         }
         responseBuffer = '';
         processing = false;
+        rejectAllInFlight(new Error('Processo C encerrado'));
         setTimeout(startCProcess, 500);
     });
 
     console.log(`[C process] ${path.basename(API_EXE)} iniciado.`);
 }
 
+function onTextData(chunk) {
+    responseBuffer += chunk;
+    // Pode vir múltiplas linhas de uma vez, ou parcial
+    let newlineIdx;
+    while ((newlineIdx = responseBuffer.indexOf('\n')) !== -1) {
+        const line = responseBuffer.slice(0, newlineIdx).trim();
+        responseBuffer = responseBuffer.slice(newlineIdx + 1);
+        if (line && pendingResolve) {
+            const resolve = pendingResolve;
+            pendingResolve = null;
+            resolve(line);
+        }
+    }
+}
+
 // ─── Fila serializada de comandos ─────────────────────────────────────────────
 const cmdQueue = [];
 let processing = false;
 
 function sendCommand(cmd) {
+    if (FRAMED) return sendFramed(cmd);
     return new Promise((resolve, reject) => {
         cmdQueue.push({ cmd, resolve, reject });
         processQueue();
@@ -109,6 +157,64 @@ function processQueue() {
     cProcess.stdin.write(cmd + '\n');
 }
 
+// ─── Cliente do protocolo framed ──────────────────────────────────────────────
+const inFlight = new Map();   // id → { resolve, reject, timeout }
+let nextFrameId = 1;
+let frameBuffer = Buffer.alloc(0);
+
+function sendFramed(cmd) {
+    return new Promise((resolve, reject) => {
+        if (!cProcess || cProcess.killed) {
+            reject(new Error('Processo C não disponível'));
+            return;
+        }
+        const id = nextFrameId;
+        nextFrameId = (nextFrameId + 1) >>> 0 || 1;
+
+        const payload = Buffer.from(cmd, 'utf8');
+        const header = Buffer.alloc(8);
+        header.writeUInt32BE(id, 0);
+        header.writeUInt32BE(payload.length, 4);
+
+        const timeout = setTimeout(() => {
+            inFlight.delete(id);
+            reject(new Error('Timeout: o processo C nao respondeu'));
+        }, 10000);
+        inFlight.set(id, { resolve, reject, timeout });
+        cProcess.stdin.write(Buffer.concat([header, payload]));
+    });
+}
+
+function onFramedData(chunk) {
+    frameBuffer = Buffer.concat([frameBuffer, chunk]);
+    while (frameBuffer.length >= 8) {
+        const id = frameBuffer.readUInt32BE(0);
+        const len = frameBuffer.readUInt32BE(4);
+        if (frameBuffer.length < 8 + len) break;
+        const text = frameBuffer.toString('utf8', 8, 8 + len);
+        frameBuffer = frameBuffer.subarray(8 + len);
+
+        const req = inFlight.get(id);
+        if (!req) continue;   // resposta de um comando que já expirou
+        inFlight.delete(id);
+        clearTimeout(req.timeout);
+        try {
+            req.resolve(JSON.parse(text));
+        } catch (e) {
+            req.reject(new Error('JSON inválido do C: ' + text.substring(0, 200)));
+        }
+    }
+}
+
+function rejectAllInFlight(err) {
+    for (const { reject, timeout } of inFlight.values()) {
+        clearTimeout(timeout);
+        reject(err);
+    }
+    inFlight.clear();
+    frameBuffer = Buffer.alloc(0);
+}
+
 // ─── Servidor HTTP ────────────────────────────────────────────────────────────
 const server = http.createServer(async (req, res) => {
     res.setHeader('Access-Control-Allow-Origin', '*');
@@ -135,9 +241,23 @@ const server = http.createServer(async (req, res) => {
             if (url === '/api/data' && method === 'GET') {
                 result = await sendCommand('GET_ALL');
 
+            } else if (url.startsWith('/api/since') && method === 'GET') {
+                // Sincronização incremental: /api/since?rev=<revisão conhecida>&epoca=<época dela>
+                const params = new URL(url, 'http://localhost').searchParams;
+                const rev = /^\d+$/.test(params.get('rev') || '') ? params.get('rev') : '0';
+                const epoca = /^\d+$/.test(params.get('epoca') || '') ? params.get('epoca') : '-1';
+                result = await sendCommand(`GET_SINCE ${rev} ${epoca}`);
+
             } else if (url === '/api/catalog' && method === 'POST') {
                 const { name, unit } = JSON.parse(body);
-                result = await sendCommand(`ADD_CATALOGO ${name}|${unit}`);
+                result = await sendCommand(`ADD_CATALOGO ${name}${SEP}${unit}`);
+
+            } else if (url.startsWith('/api/catalog/search') && method === 'GET') {
+                // Autocomplete: /api/catalog/search?q=<prefixo>&limit=<n>
+                const params = new URL(url, 'http://localhost').searchParams;
+                const q = (params.get('q') || '').replace(/[\r\n|\x1f]/g, ' ');
+                const limit = parseInt(params.get('limit'), 10) || 10;
+                result = await sendCommand(`SEARCH_CATALOGO ${q}${SEP}${limit}`);
 
             } else if (url.startsWith('/api/catalog/') && method === 'DELETE') {
                 const id = url.split('/').pop();
@@ -147,29 +267,85 @@ const server = http.createServer(async (req, res) => {
                 const { id, qtd } = JSON.parse(body);
                 result = await sendCommand(`ADD_ESTOQUE ${id} ${qtd}`);
 
+            } else if (url === '/api/stock/bulk' && method === 'POST') {
+                // Entrega inteira numa chamada: { "itens": [{ "id": 1, "qtd": 2.5 }, ...] }.
+                // Só linhas no corpo: o @arquivo do comando não é exposto pela web
+                const { itens } = JSON.parse(body);
+                if (Array.isArray(itens) && itens.length > 0 &&
+                           itens.every(it => it && Number.isInteger(it.id) && Number.isFinite(Number(it.qtd)))) {
+                    const linhas = itens.map(it => `${it.id} ${Number(it.qtd)}`);
+                    result = await sendCommand(`ADD_ESTOQUE_BULK ${linhas.length}\n${linhas.join('\n')}`);
+                } else {
+                    res.writeHead(400, { 'Content-Type': 'application/json' });
+                    res.end(JSON.stringify({ error: 'envie itens [{ id, qtd }]' }));
+                    return;
+                }
+
             } else if (url.startsWith('/api/stock/') && method === 'DELETE') {
                 const id = url.split('/').pop();
                 result = await sendCommand(`DEL_ESTOQUE ${id}`);
 
             } else if (url === '/api/recipe' && method === 'POST') {
                 const { name, preparo } = JSON.parse(body);
-                result = await sendCommand(`ADD_RECEITA ${name}|${preparo}`);
+                result = await sendCommand(`ADD_RECEITA ${name}${SEP}${preparo}`);
 
             } else if (url.match(/^\/api\/recipe\/\d+$/) && method === 'DELETE') {
                 const id = url.split('/').pop();
                 result = await sendCommand(`DEL_RECEITA ${id}`);
 
+            } else if (url === '/api/recipes/can-make' && method === 'GET') {
+                result = await sendCommand('CAN_MAKE ALL');
+
+            } else if (url.match(/^\/api\/ingredient\/\d+\/recipes$/) && method === 'GET') {
+                // Receitas afetadas se o ingrediente acabar
+                const id = url.split('/')[3];
+                result = await sendCommand(`RECEITAS_COM ${id}`);
+
+            } else if (url === '/api/stats/pools' && method === 'GET') {
+                // Alocação dos nós (pedidos, rollback) nos pools do C e da arena de textos
+                result = await sendCommand('POOL_STATS');
+
+            } else if (url.match(/^\/api\/recipe\/\d+\/can-make$/) && method === 'GET') {
+                const id = url.split('/')[3];
+                result = await sendCommand(`CAN_MAKE ${id}`);
+
             } else if (url === '/api/recipe/ingredient' && method === 'POST') {
                 const { id_receita, id_ingrediente, qtd } = JSON.parse(body);
                 result = await sendCommand(`ADD_ING_RECEITA ${id_receita} ${id_ingrediente} ${qtd}`);
 
             } else if (url === '/api/order' && method === 'POST') {
-                const { id } = JSON.parse(body);
-                result = await sendCommand(`ADD_PEDIDO ${id}`);
+                // prioridade opcional: 0 baixa, 1 normal (padrão), 2 alta
+                const { id, prioridade } = JSON.parse(body);
+                const prio = Number.isInteger(prioridade) ? ` ${prioridade}` : '';
+                result = await sendCommand(`ADD_PEDIDO ${id}${prio}`);
+
+            } else if (url === '/api/batch' && method === 'POST') {
+                // Vários comandos em uma ida ao processo C: { "commands": ["ADD_ESTOQUE 1 2", ...] },
+                // campos de texto separados por '|' qualquer que seja o protocolo do processo C
+                const { commands } = JSON.parse(body);
+                if (!Array.isArray(commands) || commands.length === 0 ||
+                    commands.some(c => typeof c !== 'string' || /[\r\n\x1f]/.test(c))) {
+                    res.writeHead(400, { 'Content-Type': 'application/json' });
+                    res.end(JSON.stringify({ error: 'commands deve ser uma lista de comandos de uma linha' }));
+                    return;
+                }
+                const negado = commands.find(c => !BATCH_PERMITIDOS.has(c.trim().split(/\s+/)[0]));
+                if (negado !== undefined) {
+                    res.writeHead(400, { 'Content-Type': 'application/json' });
+                    res.end(JSON.stringify({ error: `comando nao permitido em lote: ${negado.trim().split(/\s+/)[0]}` }));
+                    return;
+                }
+                result = await sendCommand(`BATCH ${commands.length}\n${commands.map(comandoDoLote).join('\n')}`);
 
             } else if (url === '/api/order/process' && method === 'POST') {
                 result = await sendCommand('PROCESSAR_PEDIDO');
 
+            } else if (url === '/api/order/process/batch' && method === 'POST') {
+                // Processa vários pedidos numa chamada: { "n": 10 } ou { "n": "ALL" }
+                const { n } = JSON.parse(body || '{}');
+                const arg = n === 'ALL' ? 'ALL' : (parseInt(n, 10) || 0);
+                result = await sendCommand(`PROCESSAR_LOTE ${arg}`);
+
             } else if (url.match(/^\/api\/order\/\d+$/) && method === 'DELETE') {
                 const id = url.split('/').pop();
                 result = await sendCommand(`DEL_PEDIDO ${id}`);
@@ -220,7 +396,8 @@ server.listen(PORT, () => {
 process.on('SIGINT', () => {
     console.log('\nEncerrando...');
     if (cProcess) {
-        cProcess.stdin.write('QUIT\n');
+        if (FRAMED) sendFramed('QUIT').catch(() => {});
+        else cProcess.stdin.write('QUIT\n');
         setTimeout(() => { cProcess.kill(); process.exit(0); }, 500);
     } else {
         process.exit(0);
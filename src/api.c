@@ -1,6 +1,8 @@
+#define _POSIX_C_SOURCE 200809L
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
 #include "core/catalogo.h"
 #include "core/estoque.h"
 #include "core/receitas.h"
@@ -9,153 +11,451 @@
 #include "core/persistencia.h"
 #include "core/utils.h"
 #include "app_context.h"
+#include "json.h"
+#include "historico.h"
+#include "core/hash.h"
+
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#define write_fd _write
+#define fileno_fd _fileno
+#else
+#include <unistd.h>
+#define write_fd write
+#define fileno_fd fileno
+#endif
 
 /*
  * api.c — Camada de API para o Dashboard Web
  *
  * IMPORTANTE: toda saída para o FRONTEND vai por stdout (1 linha JSON).
  * Mensagens de debug/log internas do C vão para stderr (não chegam no Node).
+ *
+ * Protocolos (escolhidos na inicialização):
+ *   texto  (padrão)   — um comando por linha, uma resposta JSON por linha.
+ *   --framed          — frames binários: [id u32 BE][tamanho u32 BE][payload].
+ *                       A resposta repete o id da requisição, então o cliente
+ *                       pode manter vários comandos em voo. Campos de texto
+ *                       são separados por 0x1F em vez de '|', e o payload não
+ *                       tem o limite de linha do modo texto. Só BATCH e
+ *                       ADD_ESTOQUE_BULK aceitam linhas depois da primeira.
+ *
+ *   --reservas        — ADD_PEDIDO reserva o estoque da receita (ou recusa na
+ *                       hora) e o processamento só consome a reserva.
+ *
+ *   --pular-bloqueados — o processamento atende o pedido mais antigo que dá
+ *                       para fazer agora; os que esbarram na falta de um
+ *                       ingrediente ficam estacionados até ele voltar a caber.
+ *
+ *   --duas-fases      — a baixa só começa depois de conferir (sem escrever)
+ *                       que todos os ingredientes cabem; pedido sem estoque
+ *                       falha sem PUSH/POP_ROLLBACK.
  */
 
 static AppContext *app = NULL;
 
-/* ─── JSON helpers ────────────────────────────────────────────────────────── */
-static void json_str(const char *s) {
-    if (!s) { printf("\"\""); return; }
-    printf("\"");
-    for (; *s; s++) {
-        unsigned char c = (unsigned char)*s;
-        if (c < 0x20) continue;          /* ignora chars de controle */
-        if (*s == '"')  { printf("\\\""); continue; }
-        if (*s == '\\') { printf("\\\\"); continue; }
-        printf("%c", *s);
+/* Revisão atual + log de mudanças, para o GET_SINCE */
+static Historico hist;
+
+/* Dentro de um BATCH as respostas viram elementos de um único array JSON */
+static int em_lote = 0;
+
+#define FRAME_MAX_PAYLOAD (16u * 1024u * 1024u)
+
+static int modo_framed = 0;
+static int modo_reserva = 0;        /* --reservas: ADD_PEDIDO reserva o estoque */
+static int modo_pular = 0;          /* --pular-bloqueados: pedido sem estoque não trava a fila */
+static int modo_duas_fases = 0;     /* --duas-fases: verifica tudo antes de baixar */
+static uint32_t id_requisicao = 0;  /* id do frame sendo respondido */
+static char sep_campos = '|';       /* 0x1F no modo framed */
+
+/* ─── Saída ───────────────────────────────────────────────────────────────── */
+
+/*
+ * Toda resposta é montada no JsonWriter 'resp' e sai do processo em
+ * fim_resposta() com uma única chamada a write() — no modo framed o
+ * cabeçalho vai no mesmo buffer, reservado no início.
+ */
+static JsonWriter resp;
+
+static void escrever_u32_be(unsigned char *b, uint32_t v) {
+    b[0] = (unsigned char)(v >> 24); b[1] = (unsigned char)(v >> 16);
+    b[2] = (unsigned char)(v >> 8);  b[3] = (unsigned char)v;
+}
+
+static uint32_t ler_u32_be(const unsigned char *b) {
+    return ((uint32_t)b[0] << 24) | ((uint32_t)b[1] << 16) | ((uint32_t)b[2] << 8) | b[3];
+}
+
+/* Prepara o buffer para uma nova resposta (reserva o cabeçalho do frame) */
+static void inicio_resposta() {
+    json_limpar(&resp);
+    if (modo_framed) json_bruto(&resp, "\0\0\0\0\0\0\0\0", 8);
+}
+
+/* write() pode escrever menos que o pedido: repete até enviar tudo */
+static void escrever_stdout(const char *p, size_t n) {
+    int fd = fileno_fd(stdout);
+    while (n > 0) {
+        long w = (long)write_fd(fd, p, (unsigned)n);
+        if (w <= 0) return;
+        p += w;
+        n -= (size_t)w;
     }
-    printf("\"");
 }
 
-static void respond_ok()         { printf("{\"ok\":true}\n");  fflush(stdout); }
-static void respond_ok_id(int id){ printf("{\"ok\":true,\"id\":%d}\n", id); fflush(stdout); }
+/* Fecha uma resposta e a envia: uma linha (texto) ou um frame (framed) */
+static void fim_resposta() {
+    if (em_lote) return;
+    if (resp.erro) {
+        /* Sem memória no meio da resposta: manda um erro curto no lugar */
+        inicio_resposta();
+        json_abrir_objeto(&resp);
+        json_campo_bool(&resp, "ok", 0);
+        json_campo_str(&resp, "error", "Memoria insuficiente para a resposta");
+        json_fechar_objeto(&resp);
+    }
+    if (modo_framed) {
+        escrever_u32_be((unsigned char *)resp.dados, id_requisicao);
+        escrever_u32_be((unsigned char *)resp.dados + 4, (uint32_t)(resp.tam - 8));
+    } else {
+        json_bruto(&resp, "\n", 1);
+    }
+    escrever_stdout(resp.dados, resp.tam);
+    inicio_resposta();
+}
+
+static void respond_ok() {
+    json_abrir_objeto(&resp);
+    json_campo_bool(&resp, "ok", 1);
+    json_fechar_objeto(&resp);
+    fim_resposta();
+}
+
+static void respond_ok_id(int id) {
+    json_abrir_objeto(&resp);
+    json_campo_bool(&resp, "ok", 1);
+    json_campo_int(&resp, "id", id);
+    json_fechar_objeto(&resp);
+    fim_resposta();
+}
+
 static void respond_fail(const char *msg) {
-    printf("{\"ok\":false,\"error\":");
-    json_str(msg);
-    printf("}\n");
-    fflush(stdout);
+    json_abrir_objeto(&resp);
+    json_campo_bool(&resp, "ok", 0);
+    json_campo_str(&resp, "error", msg);
+    json_fechar_objeto(&resp);
+    fim_resposta();
+}
+
+/* ─── Persistência ────────────────────────────────────────────────────────── */
+
+/*
+ * Cada handler anexa registros curtos no journal (pers_jrn_*) em vez de
+ * reescrever arquivos inteiros; os snapshots só são regravados quando o
+ * journal passa do limite.
+ */
+static void persistir() {
+    if (em_lote) return; /* o BATCH confere uma vez só, no final */
+    if (pers_journal_precisa_compactar() &&
+        pers_compactar(app->cat, app->banco, app->estoque, app->fila))
+        app_compactar_textos(app);
 }
 
 /* ─── Verificações de dependência ─────────────────────────────────────────── */
 
-/* Verifica se algum ingrediente de alguma receita usa este id_ingrediente */
+/* Verifica se alguma receita usa este id_ingrediente (índice invertido do banco) */
 static int ingrediente_usado_em_receita(int id_ing) {
-    for (int i = 0; i < app->banco->qtd_atual; i++) {
-        NoIngrediente *n = app->banco->vetor[i]->ingredientes;
-        while (n) {
-            if (n->id_ingrediente == id_ing) return 1;
-            n = n->prox;
-        }
-    }
-    return 0;
+    return rec_ingrediente_em_uso(app->banco, id_ing);
 }
 
-/* Verifica se algum pedido na fila usa esta receita */
+/* Verifica se algum pedido na fila usa esta receita (contagem por receita da fila) */
 static int receita_usada_em_pedido(int id_rec) {
-    NoPedido *p = app->fila->inicio;
-    while (p) {
-        if (p->receita && p->receita->id == id_rec) return 1;
-        p = p->prox;
-    }
-    return 0;
+    return ped_pedidos_da_receita(app->fila, id_rec) > 0;
 }
 
 /* ─── Impressão de coleções ───────────────────────────────────────────────── */
+static void print_ingrediente_base(const IngredienteBase *it) {
+    json_abrir_objeto(&resp);
+    json_campo_int(&resp, "id", it->id);
+    json_campo_str(&resp, "name", it->nome);
+    json_campo_str(&resp, "unit", it->unidade);
+    json_fechar_objeto(&resp);
+}
+
 static void print_catalog() {
-    printf("[");
-    for (size_t i = 0; i < app->cat->qtd_atual; i++) {
-        if (i) printf(",");
-        printf("{\"id\":%d,\"name\":", app->cat->itens[i].id);
-        json_str(app->cat->itens[i].nome);
-        printf(",\"unit\":");
-        json_str(app->cat->itens[i].unidade);
-        printf("}");
-    }
-    printf("]");
+    json_abrir_array(&resp);
+    for (size_t i = 0; i < app->cat->qtd_slots; i++)
+        if (app->cat->itens[i].id != 0) print_ingrediente_base(&app->cat->itens[i]);
+    json_fechar_array(&resp);
+}
+
+/* Quantidade em milesimos como numero JSON: 2 casas, ou 3 quando o milesimo conta */
+static void json_campo_qtd(JsonWriter *w, const char *chave, Quantidade q) {
+    json_campo_num(w, chave, qtd_em_unidades(q), qtd_casas(q));
+}
+
+static void print_item_estoque(const ItemEstoque *it) {
+    json_abrir_objeto(&resp);
+    json_campo_int(&resp, "id_ingrediente", it->id_ingrediente);
+    json_campo_qtd(&resp, "quantity", it->quantidade);
+    if (modo_reserva) json_campo_qtd(&resp, "reserved", it->reservado);
+    json_fechar_objeto(&resp);
 }
 
 static void print_stock() {
-    printf("[");
-    for (int i = 0; i < app->estoque->qtd_atual; i++) {
-        if (i) printf(",");
-        printf("{\"id_ingrediente\":%d,\"quantity\":%.2f}",
-            app->estoque->itens[i].id_ingrediente,
-            app->estoque->itens[i].quantidade);
+    json_abrir_array(&resp);
+    for (int i = 0; i < app->estoque->qtd_slots; i++)
+        if (app->estoque->itens[i].id_ingrediente >= 0) print_item_estoque(&app->estoque->itens[i]);
+    json_fechar_array(&resp);
+}
+
+static void print_receita(const Receita *r) {
+    json_abrir_objeto(&resp);
+    json_campo_int(&resp, "id", r->id);
+    json_campo_str(&resp, "name", r->nome);
+    json_campo_str(&resp, "preparo", r->modo_preparo);
+    json_chave(&resp, "ingredients");
+    json_abrir_array(&resp);
+    for (int k = 0; k < r->ingredientes.qtd; k++) {
+        const IngredienteReceita *ing = &r->ingredientes.itens[k];
+        json_abrir_objeto(&resp);
+        json_campo_int(&resp, "id", ing->id_ingrediente);
+        json_campo_qtd(&resp, "qtd", ing->quantidade);
+        json_fechar_objeto(&resp);
     }
-    printf("]");
+    json_fechar_array(&resp);
+    json_fechar_objeto(&resp);
 }
 
 static void print_recipes() {
-    printf("[");
-    for (int i = 0; i < app->banco->qtd_atual; i++) {
-        if (i) printf(",");
-        Receita *r = app->banco->vetor[i];
-        printf("{\"id\":%d,\"name\":", r->id);
-        json_str(r->nome);
-        printf(",\"preparo\":");
-        json_str(r->modo_preparo);
-        printf(",\"ingredients\":[");
-        NoIngrediente *ing = r->ingredientes;
-        int first = 1;
-        while (ing) {
-            if (!first) printf(",");
-            printf("{\"id\":%d,\"qtd\":%.2f}", ing->id_ingrediente, ing->quantidade);
-            first = 0;
-            ing = ing->prox;
-        }
-        printf("]}");
-    }
-    printf("]");
+    json_abrir_array(&resp);
+    for (int i = 0; i < app->banco->qtd_slots; i++)
+        if (app->banco->vetor[i]) print_receita(app->banco->vetor[i]);
+    json_fechar_array(&resp);
+}
+
+static void print_pedido(const NoPedido *p) {
+    json_abrir_objeto(&resp);
+    json_campo_int(&resp, "id_pedido", p->id_pedido);
+    /* Segurança: a referência à receita pode ter ficado velha */
+    const Receita *r = ped_receita(app->fila, p);
+    json_campo_int(&resp, "id_receita", r ? r->id : 0);
+    json_campo_str(&resp, "nome_receita", r ? r->nome : "[Receita removida]");
+    json_campo_int(&resp, "prioridade", p->prioridade);
+    if (modo_reserva) json_campo_bool(&resp, "reservado", p->reservado);
+    json_fechar_objeto(&resp);
 }
 
+/* Pedidos por nível, do mais alto ao mais baixo, cada nível em ordem de chegada */
 static void print_orders() {
-    printf("[");
-    NoPedido *p = app->fila->inicio;
-    int first = 1;
-    while (p) {
-        if (!first) printf(",");
-        /* Segurança: verificar se o ponteiro receita é válido */
-        if (p->receita) {
-            printf("{\"id_pedido\":%d,\"id_receita\":%d,\"nome_receita\":",
-                p->id_pedido, p->receita->id);
-            json_str(p->receita->nome);
-            printf("}");
-        } else {
-            printf("{\"id_pedido\":%d,\"id_receita\":0,\"nome_receita\":\"[Receita removida]\"}",
-                p->id_pedido);
-        }
-        first = 0;
-        p = p->prox;
-    }
-    printf("]");
+    json_abrir_array(&resp);
+    /* Pela lista principal: os estacionados estão fora das FIFOs dos níveis */
+    for (int n = PED_NUM_PRIORIDADES - 1; n >= 0; n--)
+        for (NoPedido *p = app->fila->inicio; p; p = p->prox)
+            if (p->prioridade == n) print_pedido(p);
+    json_fechar_array(&resp);
 }
 
-/* ─── Handlers ────────────────────────────────────────────────────────────── */
-static void cmd_get_all() {
-    printf("{\"catalog\":");
+/* Id do pedido que o PROCESSAR_PEDIDO tentaria agora (0 = nenhum) */
+static void print_proximo_pedido() {
+    NoPedido *p = ped_proximo(app->fila);
+    json_campo_int(&resp, "proximo_pedido", p ? p->id_pedido : 0);
+}
+
+/* Coleções completas, como campos do objeto JSON já aberto */
+static void print_tudo() {
+    json_chave(&resp, "catalog");
     print_catalog();
-    printf(",\"inventory\":");
+    json_chave(&resp, "inventory");
     print_stock();
-    printf(",\"recipes\":");
+    json_chave(&resp, "recipes");
     print_recipes();
-    printf(",\"orders\":");
+    json_chave(&resp, "orders");
     print_orders();
-    printf("}\n");
-    fflush(stdout);
+    print_proximo_pedido();
+}
+
+/* ─── Handlers ────────────────────────────────────────────────────────────── */
+static void cmd_get_all() {
+    json_abrir_objeto(&resp);
+    json_campo_int(&resp, "epoca", hist.epoca);
+    json_campo_int(&resp, "rev", hist.rev);
+    print_tudo();
+    json_fechar_objeto(&resp);
+    fim_resposta();
+}
+
+/* Resumo de uma entidade alterada desde a revisão pedida no GET_SINCE */
+typedef struct {
+    int id;
+    HistColecao colecao;
+    HistTipo primeiro;   /* primeira mudança na janela: INSERIU = cliente não a tem */
+} Alterada;
+
+/* Imprime a entidade no estado atual; 0 se ela não existe mais */
+static int print_entidade(HistColecao c, int id) {
+    switch (c) {
+    case HIST_CATALOGO: {
+        IngredienteBase *it = cat_buscar_id(app->cat, id);
+        if (it) print_ingrediente_base(it);
+        return it != NULL;
+    }
+    case HIST_ESTOQUE: {
+        int i = est_buscar_indice(app->estoque, id);
+        if (i >= 0) print_item_estoque(&app->estoque->itens[i]);
+        return i >= 0;
+    }
+    case HIST_RECEITAS: {
+        Receita *r = rec_buscar_id(app->banco, id);
+        if (r) print_receita(r);
+        return r != NULL;
+    }
+    case HIST_PEDIDOS: {
+        NoPedido *p = ped_buscar(app->fila, id);
+        if (p) print_pedido(p);
+        return p != NULL;
+    }
+    default:
+        return 0;
+    }
+}
+
+static int entidade_existe(HistColecao c, int id) {
+    switch (c) {
+    case HIST_CATALOGO: return cat_buscar_id(app->cat, id) != NULL;
+    case HIST_ESTOQUE:  return est_buscar_indice(app->estoque, id) >= 0;
+    case HIST_RECEITAS: return rec_buscar_id(app->banco, id) != NULL;
+    case HIST_PEDIDOS:  return ped_buscar(app->fila, id) != NULL;
+    default:            return 0;
+    }
+}
+
+/*
+ * Uma coleção do delta: {"inserted":[...],"updated":[...],"deleted":[ids]}.
+ * O estado atual decide o destino de cada id: se existe, vai inteiro em
+ * inserted/updated; se não existe e o cliente o tinha, vai em deleted.
+ */
+static void print_delta_colecao(const Alterada *alt, size_t n, HistColecao c) {
+    json_abrir_objeto(&resp);
+    json_chave(&resp, "inserted");
+    json_abrir_array(&resp);
+    for (size_t i = 0; i < n; i++)
+        if (alt[i].colecao == c && alt[i].primeiro == HIST_INSERIU)
+            print_entidade(c, alt[i].id);
+    json_fechar_array(&resp);
+    json_chave(&resp, "updated");
+    json_abrir_array(&resp);
+    for (size_t i = 0; i < n; i++)
+        if (alt[i].colecao == c && alt[i].primeiro != HIST_INSERIU)
+            print_entidade(c, alt[i].id);
+    json_fechar_array(&resp);
+    json_chave(&resp, "deleted");
+    json_abrir_array(&resp);
+    for (size_t i = 0; i < n; i++)
+        if (alt[i].colecao == c && alt[i].primeiro != HIST_INSERIU && !entidade_existe(c, alt[i].id))
+            json_int(&resp, alt[i].id);
+    json_fechar_array(&resp);
+    json_fechar_objeto(&resp);
+}
+
+/*
+ * GET_SINCE rev epoca: só o que mudou depois da revisão 'rev' do cliente.
+ * 'epoca' é a que veio junto com a revisão (GET_ALL / GET_SINCE). Se ela
+ * é de outra execução do processo (ou falta), ou se o log circular não
+ * cobre mais essa revisão (cliente muito atrasado), responde com o
+ * snapshot completo e "full":true.
+ */
+static void cmd_get_since(long long rev, long long epoca) {
+    if (!hist_cobre(&hist, epoca, rev)) {
+        json_abrir_objeto(&resp);
+        json_campo_bool(&resp, "ok", 1);
+        json_campo_int(&resp, "epoca", hist.epoca);
+        json_campo_int(&resp, "rev", hist.rev);
+        json_campo_bool(&resp, "full", 1);
+        print_tudo();
+        json_fechar_objeto(&resp);
+        fim_resposta();
+        return;
+    }
+
+    /* O log guarda as revisões rev_minima+1 .. rev, uma por registro */
+    size_t ini = (size_t)(rev - hist.rev_minima);
+    size_t n = 0;
+    Alterada *alt = malloc(sizeof(Alterada) * (hist.qtd - ini + 1));
+    IndiceHash vistos[HIST_NUM_COLECOES];
+    int ok = alt != NULL;
+    for (int c = 0; c < HIST_NUM_COLECOES; c++)
+        if (!hsh_inicializar(&vistos[c], hist.qtd - ini)) ok = 0;
+
+    /* Uma entrada por entidade, guardando a primeira mudança da janela */
+    for (size_t i = ini; ok && i < hist.qtd; i++) {
+        const HistMudanca *m = hist_registro(&hist, i);
+        if (hsh_buscar(&vistos[m->colecao], m->id) >= 0) continue;
+        if (!hsh_inserir(&vistos[m->colecao], m->id, (int)n)) ok = 0;
+        alt[n].id = m->id;
+        alt[n].colecao = (HistColecao)m->colecao;
+        alt[n].primeiro = (HistTipo)m->tipo;
+        n++;
+    }
+    for (int c = 0; c < HIST_NUM_COLECOES; c++) hsh_liberar(&vistos[c]);
+    if (!ok) {
+        free(alt);
+        respond_fail("Memoria insuficiente");
+        return;
+    }
+
+    json_abrir_objeto(&resp);
+    json_campo_bool(&resp, "ok", 1);
+    json_campo_int(&resp, "epoca", hist.epoca);
+    json_campo_int(&resp, "rev", hist.rev);
+    json_campo_bool(&resp, "full", 0);
+    json_chave(&resp, "catalog");
+    print_delta_colecao(alt, n, HIST_CATALOGO);
+    json_chave(&resp, "inventory");
+    print_delta_colecao(alt, n, HIST_ESTOQUE);
+    json_chave(&resp, "recipes");
+    print_delta_colecao(alt, n, HIST_RECEITAS);
+    json_chave(&resp, "orders");
+    print_delta_colecao(alt, n, HIST_PEDIDOS);
+    print_proximo_pedido();
+    json_fechar_objeto(&resp);
+    free(alt);
+    fim_resposta();
 }
 
 static void cmd_add_catalogo(const char *nome, const char *unidade) {
     int id = cat_cadastrar(app->cat, nome, unidade);
-    pers_salvar_catalogo(app->cat);
+    if (id) {
+        pers_jrn_catalogo_add(cat_buscar_id(app->cat, id));
+        hist_registrar(&hist, HIST_CATALOGO, id, HIST_INSERIU);
+    }
+    persistir();
     respond_ok_id(id);
 }
 
+#define BUSCA_LIMITE_MAX 100
+
+/* Autocomplete do catálogo: nomes que começam com o prefixo (sem diferenciar maiúsculas) */
+static void cmd_search_catalogo(const char *prefixo, int limite) {
+    if (limite <= 0) limite = 10;
+    if (limite > BUSCA_LIMITE_MAX) limite = BUSCA_LIMITE_MAX;
+
+    int ids[BUSCA_LIMITE_MAX];
+    size_t n = cat_buscar_prefixo(app->cat, prefixo, ids, (size_t)limite);
+
+    json_abrir_objeto(&resp);
+    json_campo_bool(&resp, "ok", 1);
+    json_chave(&resp, "results");
+    json_abrir_array(&resp);
+    for (size_t i = 0; i < n; i++)
+        print_ingrediente_base(cat_buscar_id(app->cat, ids[i]));
+    json_fechar_array(&resp);
+    json_fechar_objeto(&resp);
+    fim_resposta();
+}
+
 static void cmd_del_catalogo(int id) {
     /* Verifica estoque */
     if (est_buscar_indice(app->estoque, id) != -1) {
@@ -168,30 +468,55 @@ static void cmd_del_catalogo(int id) {
         return;
     }
     int ok = cat_remover(app->cat, id);
-    if (ok) pers_salvar_catalogo(app->cat);
+    if (ok) {
+        pers_jrn_catalogo_del(id);
+        hist_registrar(&hist, HIST_CATALOGO, id, HIST_REMOVEU);
+        persistir();
+    }
     if (ok) respond_ok(); else respond_fail("Item nao encontrado");
 }
 
-static void cmd_add_estoque(int id_ing, float qtd) {
+static void cmd_add_estoque(int id_ing, Quantidade qtd) {
     /* Verifica se ingrediente existe no catálogo */
     if (!cat_buscar_id(app->cat, id_ing)) {
         respond_fail("Ingrediente nao existe no catalogo");
         return;
     }
+    /* Retirada manual não pode avançar sobre o que está reservado */
+    if (qtd < 0 && modo_reserva && est_disponivel(app->estoque, id_ing) + qtd < 0) {
+        respond_fail("Quantidade reservada por pedidos na fila");
+        return;
+    }
+    int existia = est_buscar_indice(app->estoque, id_ing) != -1;
     est_adicionar(app->estoque, id_ing, qtd);
-    pers_salvar_estoque(app->estoque);
+    pers_jrn_estoque(app->estoque, id_ing);
+    hist_registrar(&hist, HIST_ESTOQUE, id_ing, existia ? HIST_ALTEROU : HIST_INSERIU);
+    persistir();
     respond_ok();
 }
 
 static void cmd_del_estoque(int id_ing) {
+    int idx = est_buscar_indice(app->estoque, id_ing);
+    if (idx != -1 && app->estoque->itens[idx].reservado > 0) {
+        respond_fail("Estoque reservado por pedidos na fila. Cancele os pedidos antes");
+        return;
+    }
     int ok = est_deletar_item(app->estoque, id_ing);
-    if (ok) pers_salvar_estoque(app->estoque);
+    if (ok) {
+        pers_jrn_estoque(app->estoque, id_ing);
+        hist_registrar(&hist, HIST_ESTOQUE, id_ing, HIST_REMOVEU);
+        persistir();
+    }
     if (ok) respond_ok(); else respond_fail("Item nao encontrado no estoque");
 }
 
 static void cmd_add_receita(const char *nome, const char *preparo) {
     int id = rec_cadastrar(app->banco, nome, preparo);
-    pers_salvar_receitas(app->banco);
+    if (id) {
+        pers_jrn_receita_add(rec_buscar_id(app->banco, id));
+        hist_registrar(&hist, HIST_RECEITAS, id, HIST_INSERIU);
+    }
+    persistir();
     respond_ok_id(id);
 }
 
@@ -202,177 +527,606 @@ static void cmd_del_receita(int id) {
         return;
     }
     int ok = rec_remover(app->banco, id);
-    if (ok) pers_salvar_receitas(app->banco);
+    if (ok) {
+        pers_jrn_receita_del(id);
+        hist_registrar(&hist, HIST_RECEITAS, id, HIST_REMOVEU);
+        persistir();
+    }
     if (ok) respond_ok(); else respond_fail("Receita nao encontrada");
 }
 
-static void cmd_add_ing_receita(int id_rec, int id_ing, float qtd) {
+/* Ingrediente que faltou quando a baixa de um pedido falha */
+typedef struct {
+    int id;
+    Quantidade necessaria;
+    int desfez;         // 1 se o estoque chegou a ser mexido e a pilha devolveu
+} FalhaBaixa;
+
+/* Campos "error" e "falhou" descrevendo o ingrediente que faltou (+ "rollback") */
+static void print_falha_baixa(const FalhaBaixa *falha, int com_rollback) {
+    const char *nome = cat_get_nome(app->cat, falha->id);
+    Quantidade disponivel = est_disponivel(app->estoque, falha->id);
+    char erro[256];
+
+    snprintf(erro, sizeof(erro), "Estoque insuficiente para: %s", nome ? nome : "???");
+    json_campo_str(&resp, "error", erro);
+    if (com_rollback) json_campo_bool(&resp, "rollback", 1);
+    json_chave(&resp, "falhou");
+    json_abrir_objeto(&resp);
+    json_campo_int(&resp, "id", falha->id);
+    json_campo_str(&resp, "nome", nome);
+    json_campo_qtd(&resp, "necessario", falha->necessaria);
+    json_campo_qtd(&resp, "disponivel", disponivel);
+    json_fechar_objeto(&resp);
+}
+
+/* ─── Reservas (modo --reservas) ──────────────────────────────────────────── */
+
+/*
+ * Com reservas, o ADD_PEDIDO separa no estoque tudo que a receita usa
+ * (ou recusa o pedido na hora) e o processamento só converte a reserva em
+ * baixa, sem caminho de rollback. As reservas não vão para o disco: na
+ * carga são refeitas percorrendo a fila em ordem (reservar_fila).
+ */
+
+/* Reserva todos os ingredientes da receita ou nenhum. Retorna 0 e preenche 'falha' */
+static int reservar_receita(const Receita *r, FalhaBaixa *falha) {
+    const IngredienteReceita *ing = r->ingredientes.itens, *fim = ing + r->ingredientes.qtd;
+    for (; ing < fim; ing++)
+        if (!est_reservar(app->estoque, ing->id_ingrediente, ing->quantidade)) break;
+    if (ing == fim) return 1;
+
+    falha->id = ing->id_ingrediente;
+    falha->necessaria = ing->quantidade;
+    for (const IngredienteReceita *k = r->ingredientes.itens; k != ing; k++)
+        est_liberar_reserva(app->estoque, k->id_ingrediente, k->quantidade);
+    return 0;
+}
+
+/* Liberar/consumir mais do que foi reservado é erro de contabilidade: só avisa no log */
+static void aviso_reserva(int id_ing) {
+    fprintf(stderr, "Aviso: reserva inconsistente no ingrediente %d\n", id_ing);
+}
+
+static void liberar_reserva_receita(const Receita *r) {
+    for (int k = 0; k < r->ingredientes.qtd; k++)
+        if (!est_liberar_reserva(app->estoque, r->ingredientes.itens[k].id_ingrediente,
+                                 r->ingredientes.itens[k].quantidade))
+            aviso_reserva(r->ingredientes.itens[k].id_ingrediente);
+}
+
+/* A parte reservada aparece no JSON do estoque: avisa o GET_SINCE */
+static void registrar_reserva_mudou(const Receita *r) {
+    for (int k = 0; k < r->ingredientes.qtd; k++)
+        hist_registrar(&hist, HIST_ESTOQUE, r->ingredientes.itens[k].id_ingrediente, HIST_ALTEROU);
+}
+
+static void liberar_reserva_pedido(NoPedido *p) {
+    const Receita *r = ped_receita(app->fila, p);
+    if (!p->reservado || !r) return;
+    liberar_reserva_receita(r);
+    p->reservado = 0;
+    registrar_reserva_mudou(r);
+}
+
+/* Refaz as reservas da fila inteira, em ordem (pedidos que não cabem ficam sem) */
+static void reservar_fila() {
+    FalhaBaixa falha;
+    for (NoPedido *p = app->fila->inicio; p; p = p->prox) {
+        const Receita *r = ped_receita(app->fila, p);
+        if (!p->reservado && r && reservar_receita(r, &falha))
+            p->reservado = 1;
+    }
+}
+
+/*
+ * Com reservas, todo pedido reservado da receita precisa continuar coberto:
+ * só a quantidade de id_ing muda, então cada um deles reserva (ou devolve)
+ * a diferença. Se o disponível não cobre a diferença de todos, a mudança é
+ * recusada antes de tocar em nada, como o ADD_PEDIDO recusa um pedido.
+ * Pedidos da receita que estavam sem reserva tentam reservar depois.
+ */
+static void cmd_add_ing_receita(int id_rec, int id_ing, Quantidade qtd) {
+    Receita *r = rec_buscar_id(app->banco, id_rec);
+    NoPedido *p;
+    Quantidade diferenca = 0;
+    long reservados = 0;
+    if (modo_reserva && r) {
+        const IngredienteReceita *atual = ing_buscar(&r->ingredientes, id_ing);
+        diferenca = qtd - (atual ? atual->quantidade : 0);
+        for (p = app->fila->inicio; p; p = p->prox)
+            if (p->id_receita == id_rec && p->reservado) reservados++;
+        if (reservados && qtd < 0) {
+            respond_fail("Quantidade negativa: os pedidos reservados da receita ficariam sem reserva");
+            return;
+        }
+        if (reservados && diferenca > 0 && est_disponivel(app->estoque, id_ing) < diferenca * reservados) {
+            FalhaBaixa falha = { id_ing, diferenca * reservados, 0 };
+            json_abrir_objeto(&resp);
+            json_campo_bool(&resp, "ok", 0);
+            print_falha_baixa(&falha, 0);
+            json_campo_int(&resp, "pedidos_reservados", (int)reservados);
+            json_fechar_objeto(&resp);
+            fim_resposta();
+            return;
+        }
+    }
+
     int ok = rec_add_ingrediente(app->banco, id_rec, id_ing, qtd);
-    if (ok) pers_salvar_receitas(app->banco);
+
+    if (ok && modo_reserva) {
+        FalhaBaixa falha;
+        for (p = app->fila->inicio; p; p = p->prox) {
+            if (p->id_receita != id_rec || !p->reservado || diferenca == 0) continue;
+            int certo = diferenca > 0 ? est_reservar(app->estoque, id_ing, diferenca)
+                                      : est_liberar_reserva(app->estoque, id_ing, -diferenca);
+            if (!certo) aviso_reserva(id_ing);
+        }
+        if (reservados && diferenca != 0) hist_registrar(&hist, HIST_ESTOQUE, id_ing, HIST_ALTEROU);
+        for (p = app->fila->inicio; p; p = p->prox) {
+            if (p->id_receita != id_rec || p->reservado) continue;
+            if (reservar_receita(r, &falha)) {
+                p->reservado = 1;
+                registrar_reserva_mudou(r);
+            }
+        }
+    }
+    if (ok) {
+        pers_jrn_receita_ing(id_rec, id_ing, qtd);
+        hist_registrar(&hist, HIST_RECEITAS, id_rec, HIST_ALTEROU);
+        /* O que cada estacionado espera pode ter mudado: todos voltam a tentar */
+        if (modo_pular) ped_desbloquear_todos(app->fila);
+        persistir();
+    }
     if (ok) respond_ok(); else respond_fail("Falha ao adicionar ingrediente");
 }
 
-static void cmd_add_pedido(int id_rec) {
+static void cmd_add_pedido(int id_rec, int prioridade) {
     Receita *r = rec_buscar_id(app->banco, id_rec);
     if (!r) { respond_fail("Receita nao encontrada"); return; }
 
-    if (!r->ingredientes) {
+    if (r->ingredientes.qtd == 0) {
         respond_fail("Receita sem ingredientes cadastrados");
         return;
     }
 
     /*
-     * O pedido é aceito na fila SEM verificar estoque.
+     * Sem reservas, o pedido é aceito na fila SEM verificar estoque.
      * A verificação real acontece na hora de PROCESSAR,
      * usando a Pilha de Rollback (transação com desfazimento).
      */
-    ped_adicionar(app->fila, r);
-    pers_salvar_pedidos(app->fila);
+    FalhaBaixa falha;
+    if (modo_reserva && !reservar_receita(r, &falha)) {
+        json_abrir_objeto(&resp);
+        json_campo_bool(&resp, "ok", 0);
+        print_falha_baixa(&falha, 0);
+        json_fechar_objeto(&resp);
+        fim_resposta();
+        return;
+    }
+    if (!ped_adicionar_prio(app->fila, r, prioridade)) {
+        if (modo_reserva) liberar_reserva_receita(r);
+        respond_fail("Falha ao enfileirar pedido");
+        return;
+    }
+    if (modo_reserva) {
+        app->fila->fim->reservado = 1;
+        registrar_reserva_mudou(r);
+    }
+    pers_jrn_pedido_add(app->fila->fim);
+    hist_registrar(&hist, HIST_PEDIDOS, app->fila->fim->id_pedido, HIST_INSERIU);
+    persistir();
     respond_ok();
 }
 
 static void cmd_del_pedido(int id_pedido) {
-    NoPedido *atual = app->fila->inicio;
-    NoPedido *anterior = NULL;
-    while (atual) {
-        if (atual->id_pedido == id_pedido) {
-            if (anterior) anterior->prox = atual->prox;
-            else          app->fila->inicio = atual->prox;
-            if (app->fila->fim == atual) app->fila->fim = anterior;
-            free(atual);
-            pers_salvar_pedidos(app->fila);
-            respond_ok();
-            return;
-        }
-        anterior = atual;
-        atual = atual->prox;
+    NoPedido *p = ped_buscar(app->fila, id_pedido);
+    if (!p) {
+        respond_fail("Pedido nao encontrado");
+        return;
+    }
+    liberar_reserva_pedido(p);
+    ped_remover(app->fila, id_pedido);
+    pers_jrn_pedido_del(id_pedido);
+    hist_registrar(&hist, HIST_PEDIDOS, id_pedido, HIST_REMOVEU);
+    persistir();
+    respond_ok();
+}
+
+/* Registro de uma operação da pilha de rollback, devolvido no JSON */
+typedef struct { int id; Quantidade qtd; const char *nome; const char *op; } PilhaLog;
+
+#define PILHA_LOG_MAX 100
+
+static void print_pilha_ops(const PilhaLog *logs, int n) {
+    json_chave(&resp, "pilha_ops");
+    json_abrir_array(&resp);
+    for (int i = 0; i < n; i++) {
+        json_abrir_objeto(&resp);
+        json_campo_str(&resp, "op", logs[i].op);
+        json_campo_int(&resp, "id", logs[i].id);
+        json_campo_str(&resp, "nome", logs[i].nome);
+        json_campo_qtd(&resp, "qtd", logs[i].qtd);
+        json_fechar_objeto(&resp);
     }
-    respond_fail("Pedido nao encontrado");
+    json_fechar_array(&resp);
 }
 
+static void registrar_op(PilhaLog *logs, int *logCount, const char *op, int id, Quantidade qtd) {
+    if (!logs || *logCount >= PILHA_LOG_MAX) return;
+    logs[*logCount].id = id;
+    logs[*logCount].qtd = qtd;
+    logs[*logCount].nome = cat_get_nome(app->cat, id);
+    logs[*logCount].op = op;
+    (*logCount)++;
+}
+
+/* Tira da fila um pedido cuja receita não existe mais */
+static void descartar_pedido(int id_pedido) {
+    ped_remover(app->fila, id_pedido);
+    pers_jrn_pedido_del(id_pedido);
+    hist_registrar(&hist, HIST_PEDIDOS, id_pedido, HIST_REMOVEU);
+}
+
+/*
+    retirar_com_rollback
+        - Lógica transacional com Pilha de Rollback. Para cada ingrediente:
+            1. Tenta remover a quantidade do estoque
+            2. Se conseguiu → rb_push(id, qtd) empilha o registro
+            3. Se falhou → ROLLBACK: rb_pop() desempilha cada item e devolve ao estoque
+        - Com --duas-fases, antes disso uma verificação só de leitura
+          recusa o pedido sem tocar no estoque; a pilha vira só uma guarda.
+        - Retorna 1 se retirou tudo, 0 (com 'falha' preenchida) se não.
+        - 'logs' (opcional) recebe as operações da pilha; 'rb' deve vir vazia.
+ */
+static int retirar_com_rollback(const Receita *r, PilhaRollback *rb,
+                                PilhaLog *logs, int *logCount, FalhaBaixa *falha) {
+    const IngredienteReceita *ing, *fim = r->ingredientes.itens + r->ingredientes.qtd;
+
+    /* Fase 0 (--duas-fases): verificação sem escrita */
+    if (modo_duas_fases && (ing = ped_ingrediente_em_falta(r, app->estoque))) {
+        falha->id = ing->id_ingrediente;
+        falha->necessaria = ing->quantidade;
+        falha->desfez = 0;
+        return 0;
+    }
+
+    /* Fase 1: Tentativa — retira cada ingrediente e empilha */
+    for (ing = r->ingredientes.itens; ing < fim; ing++) {
+        if (!est_remover(app->estoque, ing->id_ingrediente, ing->quantidade)) break;
+        rb_push(rb, ing->id_ingrediente, ing->quantidade);
+        registrar_op(logs, logCount, "PUSH", ing->id_ingrediente, ing->quantidade);
+    }
+    if (ing == fim) return 1;
+
+    /* Fase 2: Rollback — desempilha e devolve ao estoque */
+    int pop_id; Quantidade pop_qtd;
+    while (rb_pop(rb, &pop_id, &pop_qtd)) {
+        est_adicionar(app->estoque, pop_id, pop_qtd);
+        registrar_op(logs, logCount, "POP_ROLLBACK", pop_id, pop_qtd);
+    }
+    falha->id = ing->id_ingrediente;
+    falha->necessaria = ing->quantidade;
+    falha->desfez = 1;
+    return 0;
+}
+
+/*
+    baixar_pedido
+        - Pedido reservado: a reserva vira baixa direto (não pode faltar).
+          Senão: retirar_com_rollback, que pode falhar e retornar 0.
+        - Em sucesso registra a baixa no journal (uma transação) e remove o
+          pedido da fila; retorna 1.
+ */
+static int baixar_pedido(NoPedido *pedido, PilhaRollback *rb,
+                         PilhaLog *logs, int *logCount, FalhaBaixa *falha) {
+    Receita *r = ped_receita(app->fila, pedido);
+    const IngredienteReceita *ing, *fim = r->ingredientes.itens + r->ingredientes.qtd;
+
+    if (pedido->reservado) {
+        for (ing = r->ingredientes.itens; ing < fim; ing++)
+            if (!est_consumir_reserva(app->estoque, ing->id_ingrediente, ing->quantidade))
+                aviso_reserva(ing->id_ingrediente);
+    } else if (!retirar_com_rollback(r, rb, logs, logCount, falha)) {
+        return 0;
+    }
+
+    /* Sucesso: registra a baixa no journal como uma transação e remove o pedido da fila */
+    pers_jrn_transacao_inicio();
+    for (ing = r->ingredientes.itens; ing < fim; ing++) {
+        pers_jrn_estoque(app->estoque, ing->id_ingrediente);
+        hist_registrar(&hist, HIST_ESTOQUE, ing->id_ingrediente, HIST_ALTEROU);
+    }
+    pers_jrn_pedido_del(pedido->id_pedido);
+    pers_jrn_transacao_fim();
+    hist_registrar(&hist, HIST_PEDIDOS, pedido->id_pedido, HIST_REMOVEU);
+    ped_concluir(app->fila, pedido->id_pedido);
+    rb_limpar(rb);
+    return 1;
+}
+
+/* ─── Espera por ingrediente (modo --pular-bloqueados) ───────────────────── */
+
+/*
+ * Um pedido que falha por falta do ingrediente X fica estacionado na lista
+ * de espera de X e sai da FIFO do nível (ped_proximo não o vê mais). O
+ * estoque avisa cada mudança de quantidade (ped_ligar_espera); só a lista
+ * do ingrediente que mudou é percorrida, e só quem passou a caber volta.
+ */
+static void ligar_espera(AppContext *a) {
+    if (modo_pular && !ped_ligar_espera(a->fila, a->estoque))
+        fprintf(stderr, "Aviso: fila de espera por ingrediente indisponivel\n");
+}
+
+#define PULADOS_MAX 100
+
 static void cmd_processar_pedido() {
-    if (!app->fila->inicio) {
-        respond_fail("Fila vazia");
+    NoPedido *pedido = ped_proximo(app->fila);
+    if (!pedido) {
+        respond_fail(app->fila->contador_pedidos ? "Todos os pedidos aguardam estoque" : "Fila vazia");
         return;
     }
 
-    NoPedido *pedido = app->fila->inicio;
-    Receita *r = pedido->receita;
-
-    if (!r) {
-        app->fila->inicio = pedido->prox;
-        if (!app->fila->inicio) app->fila->fim = NULL;
-        free(pedido);
-        pers_salvar_pedidos(app->fila);
+    if (!ped_receita(app->fila, pedido)) {
+        descartar_pedido(pedido->id_pedido);
+        persistir();
         respond_fail("Pedido com receita invalida descartado");
         return;
     }
 
-    /*
-     * Lógica transacional com Pilha de Rollback:
-     *
-     * Para cada ingrediente da receita:
-     *   1. Tenta remover a quantidade do estoque
-     *   2. Se conseguiu → rb_push(id, qtd) empilha o registro
-     *   3. Se falhou → ROLLBACK: rb_pop() desempilha cada item e devolve ao estoque
-     *
-     * O JSON de resposta inclui o log detalhado de cada operação da pilha.
-     */
-    PilhaRollback *rb = rb_criar();
-    NoIngrediente *ing = r->ingredientes;
-    int sucesso = 1;
-    int pushCount = 0;
-    int falhou_id = -1;
-    float falhou_necessaria = 0;
-
-    /* Array para log das operações da pilha (max 50 ingredientes) */
-    typedef struct { int id; float qtd; const char *nome; const char *op; } PilhaLog;
-    PilhaLog logs[100];
+    /* O JSON de resposta inclui o log detalhado de cada operação da pilha */
+    PilhaRollback *rb = app->rollback;
+    PilhaLog logs[PILHA_LOG_MAX];
     int logCount = 0;
+    FalhaBaixa falha;
+    int pulados[PULADOS_MAX], qtd_pulados = 0, descartou = 0;
+    int id_pedido, reservado, sucesso;
 
-    /* Fase 1: Tentativa — retira cada ingrediente e empilha */
-    while (ing) {
-        if (est_remover(app->estoque, ing->id_ingrediente, ing->quantidade)) {
-            rb_push(rb, ing->id_ingrediente, ing->quantidade);
-            pushCount++;
-            if (logCount < 100) {
-                logs[logCount].id = ing->id_ingrediente;
-                logs[logCount].qtd = ing->quantidade;
-                logs[logCount].nome = cat_get_nome(app->cat, ing->id_ingrediente);
-                logs[logCount].op = "PUSH";
-                logCount++;
-            }
-        } else {
-            sucesso = 0;
-            falhou_id = ing->id_ingrediente;
-            falhou_necessaria = ing->quantidade;
-            break;
+    for (;;) {
+        id_pedido = pedido->id_pedido;
+        reservado = pedido->reservado;
+        logCount = 0;
+        sucesso = baixar_pedido(pedido, rb, logs, &logCount, &falha);
+        if (sucesso || !modo_pular) break;
+
+        /* Estaciona e tenta o próximo livre; o log que volta é o da última tentativa */
+        if (!ped_bloquear(app->fila, pedido, falha.id, falha.necessaria)) break;
+        if (qtd_pulados < PULADOS_MAX) pulados[qtd_pulados++] = id_pedido;
+        while ((pedido = ped_proximo(app->fila)) && !ped_receita(app->fila, pedido)) {
+            descartar_pedido(pedido->id_pedido);
+            descartou = 1;
         }
-        ing = ing->prox;
-    }
-
-    if (!sucesso) {
-        /* Fase 2: Rollback — desempilha e devolve ao estoque */
-        int pop_id; float pop_qtd;
-        while (rb_pop(rb, &pop_id, &pop_qtd)) {
-            est_adicionar(app->estoque, pop_id, pop_qtd);
-            if (logCount < 100) {
-                logs[logCount].id = pop_id;
-                logs[logCount].qtd = pop_qtd;
-                logs[logCount].nome = cat_get_nome(app->cat, pop_id);
-                logs[logCount].op = "POP_ROLLBACK";
-                logCount++;
+        if (!pedido) break;
+    }
+    if (sucesso || descartou) persistir();
+
+    json_abrir_objeto(&resp);
+    if (sucesso) {
+        json_campo_bool(&resp, "ok", 1);
+        if (reservado) json_campo_bool(&resp, "reservado", 1);
+    } else {
+        /* Log detalhado do rollback + info do que faltou */
+        json_campo_bool(&resp, "ok", 0);
+        print_falha_baixa(&falha, falha.desfez);
+    }
+    if (modo_pular) {
+        json_campo_int(&resp, "id_pedido", id_pedido);
+        json_chave(&resp, "pulados");
+        json_abrir_array(&resp);
+        for (int i = 0; i < qtd_pulados; i++) json_int(&resp, pulados[i]);
+        json_fechar_array(&resp);
+        json_campo_int(&resp, "bloqueados", app->fila->qtd_bloqueados);
+    }
+    print_pilha_ops(logs, logCount);
+    json_fechar_objeto(&resp);
+    fim_resposta();
+}
+
+/*
+ * PROCESSAR_LOTE n|ALL: processa até n pedidos na ordem de atendimento
+ * (ped_proximo), cada um com o mesmo rollback do PROCESSAR_PEDIDO. Para no
+ * primeiro pedido sem estoque (ele continua sendo o próximo); com
+ * --pular-bloqueados ele é estacionado e o lote segue com os livres, e
+ * "bloqueado" indica que sobraram só pedidos à espera. Pedidos com
+ * receita inválida são descartados e o lote segue. O journal do lote
+ * inteiro é uma transação só e a compactação é conferida uma vez, no fim.
+ */
+static void cmd_processar_lote(int limite) {
+    PilhaRollback *rb = app->rollback;
+    int processados = 0, descartados = 0, bloqueado = 0, estacionados = 0;
+
+    json_abrir_objeto(&resp);
+    json_campo_bool(&resp, "ok", 1);
+    json_chave(&resp, "pedidos");
+    json_abrir_array(&resp);
+
+    pers_jrn_transacao_inicio();
+    NoPedido *pedido;
+    while ((pedido = ped_proximo(app->fila)) && (limite < 0 || processados + descartados < limite)) {
+        int id_pedido = pedido->id_pedido;
+        FalhaBaixa falha;
+
+        json_abrir_objeto(&resp);
+        json_campo_int(&resp, "id_pedido", id_pedido);
+        if (!ped_receita(app->fila, pedido)) {
+            descartar_pedido(id_pedido);
+            descartados++;
+            json_campo_bool(&resp, "ok", 0);
+            json_campo_str(&resp, "error", "Pedido com receita invalida descartado");
+        } else {
+            json_campo_int(&resp, "id_receita", pedido->id_receita);
+            if (baixar_pedido(pedido, rb, NULL, NULL, &falha)) {
+                processados++;
+                json_campo_bool(&resp, "ok", 1);
+            } else {
+                json_campo_bool(&resp, "ok", 0);
+                print_falha_baixa(&falha, falha.desfez);
+                if (modo_pular && ped_bloquear(app->fila, pedido, falha.id, falha.necessaria))
+                    estacionados++;
+                else
+                    bloqueado = 1;
             }
         }
-        rb_liberar(rb);
-
-        /* Info do ingrediente que falhou */
-        const char *falhou_nome = cat_get_nome(app->cat, falhou_id);
-        int falhou_idx = est_buscar_indice(app->estoque, falhou_id);
-        float falhou_disponivel = (falhou_idx != -1) ? app->estoque->itens[falhou_idx].quantidade : 0;
-
-        /* Monta JSON com log detalhado do rollback + info do que faltou */
-        printf("{\"ok\":false,\"error\":\"Estoque insuficiente para: %s\",\"rollback\":true,",
-            falhou_nome ? falhou_nome : "???");
-        printf("\"falhou\":{\"id\":%d,\"nome\":", falhou_id);
-        json_str(falhou_nome);
-        printf(",\"necessario\":%.2f,\"disponivel\":%.2f},", falhou_necessaria, falhou_disponivel);
-        printf("\"pilha_ops\":[");
-        for (int i = 0; i < logCount; i++) {
-            if (i) printf(",");
-            printf("{\"op\":\"%s\",\"id\":%d,\"nome\":", logs[i].op, logs[i].id);
-            json_str(logs[i].nome);
-            printf(",\"qtd\":%.2f}", logs[i].qtd);
-        }
-        printf("]}\n");
-        fflush(stdout);
-        return;
+        json_fechar_objeto(&resp);
+        if (bloqueado) break;
     }
+    pers_jrn_transacao_fim();
+    persistir();
+    if (modo_pular && !bloqueado)
+        bloqueado = app->fila->contador_pedidos > 0 && !ped_proximo(app->fila);
+
+    json_fechar_array(&resp);
+    json_campo_int(&resp, "processados", processados);
+    json_campo_int(&resp, "descartados", descartados);
+    json_campo_bool(&resp, "bloqueado", bloqueado);
+    if (modo_pular) json_campo_int(&resp, "estacionados", estacionados);
+    json_campo_int(&resp, "restantes", app->fila->contador_pedidos);
+    json_fechar_objeto(&resp);
+    fim_resposta();
+}
 
-    /* Sucesso: remove pedido da fila */
-    app->fila->inicio = pedido->prox;
-    if (!app->fila->inicio) app->fila->fim = NULL;
-    free(pedido);
+/*
+ * RECEITAS_COM id_ingrediente: receitas que usam o ingrediente e quanto
+ * cada uma pede, direto do índice invertido do banco de receitas.
+ */
+static void cmd_receitas_com(int id_ing) {
+    const int *ids;
+    int n = rec_receitas_com(app->banco, id_ing, &ids);
 
-    rb_liberar(rb);
-    pers_salvar_estoque(app->estoque);
-    pers_salvar_pedidos(app->fila);
+    json_abrir_objeto(&resp);
+    json_campo_bool(&resp, "ok", 1);
+    json_campo_int(&resp, "id_ingrediente", id_ing);
+    json_chave(&resp, "receitas");
+    json_abrir_array(&resp);
+    for (int i = 0; i < n; i++) {
+        const Receita *r = rec_buscar_id(app->banco, ids[i]);
+        const IngredienteReceita *ing = r ? ing_buscar(&r->ingredientes, id_ing) : NULL;
+        if (!ing) continue;
+        json_abrir_objeto(&resp);
+        json_campo_int(&resp, "id", r->id);
+        json_campo_str(&resp, "name", r->nome);
+        json_campo_qtd(&resp, "qtd", ing->quantidade);
+        json_fechar_objeto(&resp);
+    }
+    json_fechar_array(&resp);
+    json_fechar_objeto(&resp);
+    fim_resposta();
+}
+
+/*
+ * CAN_MAKE id|ALL: quantas porções de cada receita o estoque atual permite.
+ * Os valores vêm do cache de produção, que só recalcula as receitas
+ * cujos ingredientes mudaram de quantidade.
+ */
+static void cmd_can_make(int id_receita) {
+    int porcoes = prd_porcoes(app->producao, id_receita);
+    if (porcoes < 0) { respond_fail("Receita nao encontrada"); return; }
+    json_abrir_objeto(&resp);
+    json_campo_bool(&resp, "ok", 1);
+    json_campo_int(&resp, "id_receita", id_receita);
+    json_campo_int(&resp, "porcoes", porcoes);
+    json_fechar_objeto(&resp);
+    fim_resposta();
+}
 
-    /* JSON de sucesso com log das operações da pilha */
-    printf("{\"ok\":true,\"pilha_ops\":[");
-    for (int i = 0; i < logCount; i++) {
-        if (i) printf(",");
-        printf("{\"op\":\"%s\",\"id\":%d,\"nome\":", logs[i].op, logs[i].id);
-        json_str(logs[i].nome);
-        printf(",\"qtd\":%.2f}", logs[i].qtd);
+static void cmd_can_make_todas() {
+    json_abrir_objeto(&resp);
+    json_campo_bool(&resp, "ok", 1);
+    json_chave(&resp, "receitas");
+    json_abrir_array(&resp);
+    for (int i = 0; i < app->banco->qtd_slots; i++) {
+        if (!app->banco->vetor[i]) continue;
+        int id = app->banco->vetor[i]->id;
+        json_abrir_objeto(&resp);
+        json_campo_int(&resp, "id_receita", id);
+        json_campo_int(&resp, "porcoes", prd_porcoes(app->producao, id));
+        json_fechar_objeto(&resp);
     }
-    printf("]}\n");
-    fflush(stdout);
+    json_fechar_array(&resp);
+    json_fechar_objeto(&resp);
+    fim_resposta();
+}
+
+/*
+ * POOL_STATS: números de cada pool de nós do AppContext. "slabs" é quantas
+ * vezes o pool precisou do malloc; com a fila girando, "reaproveitados"
+ * cresce e "slabs" fica parado. "strings" resume a arena de textos.
+ */
+static void print_pool(const PoolFixo *pool) {
+    const PoolStats *st = &pool->stats;
+    json_abrir_objeto(&resp);
+    json_campo_str(&resp, "nome", pool->nome);
+    json_campo_int(&resp, "tam_obj", (long long)pool->tam_obj);
+    json_campo_int(&resp, "slabs", (long long)st->slabs);
+    json_campo_int(&resp, "capacidade", (long long)(st->slabs * POOL_OBJS_POR_SLAB));
+    json_campo_int(&resp, "em_uso", (long long)st->em_uso);
+    json_campo_int(&resp, "pico", (long long)st->pico);
+    json_campo_int(&resp, "alocacoes", (long long)st->alocacoes);
+    json_campo_int(&resp, "reaproveitados", (long long)st->reaproveitados);
+    json_campo_int(&resp, "devolucoes", (long long)st->devolucoes);
+    json_fechar_objeto(&resp);
+}
+
+static void cmd_pool_stats() {
+    json_abrir_objeto(&resp);
+    json_campo_bool(&resp, "ok", 1);
+    json_chave(&resp, "pools");
+    json_abrir_array(&resp);
+    print_pool(&app->pool_pedidos);
+    print_pool(&app->pool_rollback);
+    json_fechar_array(&resp);
+
+    /* Arena dos textos: "reaproveitadas" conta as cópias que a internação evitou */
+    const ArenaStats *st = &app->strings.stats;
+    json_chave(&resp, "strings");
+    json_abrir_objeto(&resp);
+    json_campo_int(&resp, "blocos", (long long)st->blocos);
+    json_campo_int(&resp, "bytes", (long long)st->bytes);
+    json_campo_int(&resp, "copias", (long long)st->copias);
+    json_campo_int(&resp, "internadas", (long long)st->internadas);
+    json_campo_int(&resp, "reaproveitadas", (long long)st->reaproveitadas);
+    json_fechar_objeto(&resp);
+    json_fechar_objeto(&resp);
+    fim_resposta();
+}
+
+/* Grava o estado atual no snapshot binário (passa a ser usado na carga) */
+static void cmd_export_bin() {
+    if (pers_exportar_binario(PATH_SNAPSHOT_BIN, app->cat, app->banco, app->estoque, app->fila))
+        respond_ok();
+    else
+        respond_fail("Falha ao gravar snapshot binario");
+}
+
+/*
+ * Recarrega tudo a partir dos arquivos texto (+ journal), descartando o
+ * estado em memória, e regrava o snapshot binário a partir deles.
+ * Útil depois de editar os arquivos texto de data/ à mão.
+ */
+static void cmd_import_text() {
+    AppContext *novo = app_criar();
+    if (!novo) { respond_fail("Memoria insuficiente"); return; }
+    ligar_espera(novo);
+    if (!pers_carregar_texto(novo->cat, novo->banco, novo->estoque, novo->fila)) {
+        app_destruir(novo);
+        respond_fail("Falha ao ler " PATH_INGREDIENTES);
+        return;
+    }
+    pers_journal_reaplicar(novo->cat, novo->banco, novo->estoque, novo->fila);
+
+    app_destruir(app);
+    app = novo;
+    if (modo_reserva) reservar_fila();
+    hist_invalidar(&hist);
+    int ok = pers_exportar_binario(PATH_SNAPSHOT_BIN, app->cat, app->banco, app->estoque, app->fila)
+          && pers_compactar(app->cat, app->banco, app->estoque, app->fila);
+    if (ok) respond_ok(); else respond_fail("Falha ao gravar snapshot binario");
 }
 
 /* ─── Parsing ─────────────────────────────────────────────────────────────── */
-static int split_pipe(const char *src, char *a, int sa, char *b, int sb) {
-    const char *pipe = strchr(src, '|');
+/* Divide "a<sep>b" (sep = '|' no modo texto, 0x1F no modo framed) */
+static int split_campos(const char *src, char *a, int sa, char *b, int sb) {
+    const char *pipe = strchr(src, sep_campos);
     if (!pipe) return 0;
     int la = (int)(pipe - src);
     if (la >= sa) la = sa - 1;
@@ -384,78 +1138,446 @@ static int split_pipe(const char *src, char *a, int sa, char *b, int sb) {
     return 1;
 }
 
-/* ─── Main loop ───────────────────────────────────────────────────────────── */
-int main() {
-    app = app_criar();
-    if (!app) { fprintf(stderr, "Erro ao inicializar\n"); return 1; }
+/* ─── Dispatcher ──────────────────────────────────────────────────────────── */
 
-    pers_carregar_catalogo(app->cat);
-    pers_carregar_receitas(app->banco);
-    pers_carregar_estoque(app->estoque);
-    pers_carregar_pedidos(app->fila, app->banco);
+#define API_MAX_LINHA 2048
 
-    /* Redireciona stdout dos módulos internos: usamos setvbuf para flush imediato */
-    setvbuf(stdout, NULL, _IONBF, 0);
+static void cmd_batch(int n);
+static void cmd_add_estoque_bulk(const char *args);
 
-    char linha[2048];
-    while (fgets(linha, sizeof(linha), stdin)) {
-        utl_chomp(linha);
-        if (!strlen(linha)) continue;
-
-        char cmd[32];
-        sscanf(linha, "%31s", cmd);
-        const char *args = linha + strlen(cmd);
-        while (*args == ' ') args++;
-
-        if      (!strcmp(cmd, "GET_ALL"))          cmd_get_all();
-        else if (!strcmp(cmd, "ADD_CATALOGO")) {
-            char nome[128], unidade[32];
-            if (split_pipe(args, nome, sizeof(nome), unidade, sizeof(unidade)))
-                cmd_add_catalogo(nome, unidade);
-            else respond_fail("Formato invalido: nome|unidade");
+/* No modo framed, as linhas de um BATCH vêm no próprio payload, após o '\n' */
+static const char *corpo_lote = NULL;
+
+static int proxima_linha_lote(char *buf, size_t tam) {
+    if (!corpo_lote) return fgets(buf, (int)tam, stdin) != NULL;
+    if (!*corpo_lote) return 0;
+    const char *fim = strchr(corpo_lote, '\n');
+    size_t len = fim ? (size_t)(fim - corpo_lote) : strlen(corpo_lote);
+    if (len >= tam) len = tam - 1;
+    memcpy(buf, corpo_lote, len);
+    buf[len] = '\0';
+    corpo_lote = fim ? fim + 1 : corpo_lote + strlen(corpo_lote);
+    return 1;
+}
+
+/* Executa uma linha de comando. Retorna 0 se o comando pede para encerrar (QUIT) */
+static int executar_comando(const char *linha) {
+    char cmd[32];
+    if (sscanf(linha, "%31s", cmd) != 1) return 1;
+    const char *args = linha + strlen(cmd);
+    while (*args == ' ') args++;
+
+    if      (!strcmp(cmd, "GET_ALL"))          cmd_get_all();
+    else if (!strcmp(cmd, "GET_SINCE")) {
+        /* Sem a época (cliente antigo) a resposta é sempre completa */
+        long long rev, epoca = -1;
+        if (sscanf(args, "%lld %lld", &rev, &epoca) >= 1) cmd_get_since(rev, epoca);
+        else respond_fail("Formato: GET_SINCE rev epoca");
+    }
+    else if (!strcmp(cmd, "ADD_CATALOGO")) {
+        char nome[128], unidade[32];
+        if (split_campos(args, nome, sizeof(nome), unidade, sizeof(unidade)))
+            cmd_add_catalogo(nome, unidade);
+        else respond_fail("Formato invalido: nome|unidade");
+    }
+    else if (!strcmp(cmd, "SEARCH_CATALOGO")) {
+        /* Formato: prefixo|limite (o prefixo pode ser vazio ou ter espaços).
+           Sem separador, o texto todo é o prefixo e o limite fica no padrão */
+        char prefixo[128], limite_txt[32];
+        int limite = 10, valido = 1;
+        if (split_campos(args, prefixo, sizeof(prefixo), limite_txt, sizeof(limite_txt))) {
+            char *fim;
+            long l = strtol(limite_txt, &fim, 10);
+            if (!limite_txt[0] || *fim || l <= 0) valido = 0;
+            else limite = l > BUSCA_LIMITE_MAX ? BUSCA_LIMITE_MAX : (int)l;
+        } else {
+            strncpy(prefixo, args, sizeof(prefixo) - 1);
+            prefixo[sizeof(prefixo) - 1] = '\0';
         }
-        else if (!strcmp(cmd, "DEL_CATALOGO")) {
-            int id; if (sscanf(args, "%d", &id) == 1) cmd_del_catalogo(id);
-            else respond_fail("ID invalido");
+        if (valido) cmd_search_catalogo(prefixo, limite);
+        else respond_fail("Formato: prefixo|limite (limite inteiro positivo)");
+    }
+    else if (!strcmp(cmd, "DEL_CATALOGO")) {
+        int id; if (sscanf(args, "%d", &id) == 1) cmd_del_catalogo(id);
+        else respond_fail("ID invalido");
+    }
+    else if (!strcmp(cmd, "ADD_ESTOQUE")) {
+        int id, lidos = 0; Quantidade qtd;
+        if (sscanf(args, "%d %n", &id, &lidos) == 1 && lidos > 0 && qtd_ler(args + lidos, &qtd))
+            cmd_add_estoque(id, qtd);
+        else respond_fail("Formato: id quantidade");
+    }
+    else if (!strcmp(cmd, "ADD_ESTOQUE_BULK")) cmd_add_estoque_bulk(args);
+    else if (!strcmp(cmd, "DEL_ESTOQUE")) {
+        int id; if (sscanf(args, "%d", &id) == 1) cmd_del_estoque(id);
+        else respond_fail("ID invalido");
+    }
+    else if (!strcmp(cmd, "ADD_RECEITA")) {
+        char nome[128], preparo[512];
+        if (split_campos(args, nome, sizeof(nome), preparo, sizeof(preparo)))
+            cmd_add_receita(nome, preparo);
+        else respond_fail("Formato: nome|preparo");
+    }
+    else if (!strcmp(cmd, "DEL_RECEITA")) {
+        int id; if (sscanf(args, "%d", &id) == 1) cmd_del_receita(id);
+        else respond_fail("ID invalido");
+    }
+    else if (!strcmp(cmd, "ADD_ING_RECEITA")) {
+        int id_rec, id_ing, lidos = 0; Quantidade qtd;
+        if (sscanf(args, "%d %d %n", &id_rec, &id_ing, &lidos) == 2 && lidos > 0 && qtd_ler(args + lidos, &qtd))
+            cmd_add_ing_receita(id_rec, id_ing, qtd);
+        else respond_fail("Formato: id_rec id_ing qtd");
+    }
+    else if (!strcmp(cmd, "ADD_PEDIDO")) {
+        /* Formato: id_receita [prioridade 0..2] — sem prioridade, normal */
+        int id, prio = PED_PRIO_NORMAL;
+        int n = sscanf(args, "%d %d", &id, &prio);
+        if (n < 1) respond_fail("ID invalido");
+        else if (prio < 0 || prio >= PED_NUM_PRIORIDADES) respond_fail("Prioridade invalida (0 baixa, 1 normal, 2 alta)");
+        else cmd_add_pedido(id, prio);
+    }
+    else if (!strcmp(cmd, "DEL_PEDIDO")) {
+        int id; if (sscanf(args, "%d", &id) == 1) cmd_del_pedido(id);
+        else respond_fail("ID invalido");
+    }
+    else if (!strcmp(cmd, "PROCESSAR_PEDIDO")) cmd_processar_pedido();
+    else if (!strcmp(cmd, "PROCESSAR_LOTE")) {
+        int n;
+        if (!strcmp(args, "ALL")) cmd_processar_lote(-1);
+        else if (sscanf(args, "%d", &n) == 1 && n > 0) cmd_processar_lote(n);
+        else respond_fail("Formato: PROCESSAR_LOTE n|ALL");
+    }
+    else if (!strcmp(cmd, "CAN_MAKE")) {
+        int id;
+        if (!strcmp(args, "ALL")) cmd_can_make_todas();
+        else if (sscanf(args, "%d", &id) == 1) cmd_can_make(id);
+        else respond_fail("Formato: CAN_MAKE id|ALL");
+    }
+    else if (!strcmp(cmd, "RECEITAS_COM")) {
+        int id; if (sscanf(args, "%d", &id) == 1) cmd_receitas_com(id);
+        else respond_fail("ID invalido");
+    }
+    else if (!strcmp(cmd, "POOL_STATS"))       cmd_pool_stats();
+    else if (!strcmp(cmd, "EXPORT_BIN"))       cmd_export_bin();
+    else if (!strcmp(cmd, "IMPORT_TEXT"))      cmd_import_text();
+    else if (!strcmp(cmd, "BATCH")) {
+        int n;
+        if (em_lote) respond_fail("BATCH aninhado nao permitido");
+        else if (sscanf(args, "%d", &n) == 1 && n > 0) cmd_batch(n);
+        else respond_fail("Formato: BATCH n");
+    }
+    else if (!strcmp(cmd, "QUIT")) {
+        if (!em_lote) return 0;
+        respond_fail("QUIT nao permitido em BATCH");
+    }
+    else respond_fail("Comando desconhecido");
+    return 1;
+}
+
+/*
+ * BATCH n: lê as próximas n linhas do stdin como subcomandos e responde
+ * com um único array JSON (uma resposta por subcomando, na ordem).
+ * Os registros do journal do lote inteiro formam uma transação (um flush)
+ * e a compactação é verificada uma vez só, no final.
+ */
+static void cmd_batch(int n) {
+    char linha[API_MAX_LINHA];
+
+    em_lote = 1;
+    pers_jrn_transacao_inicio();
+    json_abrir_array(&resp);
+    for (int i = 0; i < n && proxima_linha_lote(linha, sizeof(linha)); i++) {
+        utl_chomp(linha);
+        if (!strlen(linha)) respond_fail("Comando vazio");
+        else executar_comando(linha);
+    }
+    json_fechar_array(&resp);
+    pers_jrn_transacao_fim();
+    em_lote = 0;
+
+    fim_resposta();
+    persistir();
+}
+
+/* ─── Entrada de estoque em lote ──────────────────────────────────────────── */
+
+#define ENTREGA_MAX_LINHAS 100000
+
+/* Uma linha da entrega; erro != NULL = recusada (vai para "erros") */
+typedef struct {
+    int linha;
+    int id;
+    Quantidade qtd;
+    const char *erro;
+} LinhaEntrega;
+
+/* Recusadas primeiro, na ordem das linhas; depois as aceitas por id (e linha) */
+static int comparar_entrega(const void *a, const void *b) {
+    const LinhaEntrega *x = a, *y = b;
+    if (!x->erro != !y->erro) return x->erro ? -1 : 1;
+    if (!x->erro && x->id != y->id) return x->id < y->id ? -1 : 1;
+    return (x->linha > y->linha) - (x->linha < y->linha);
+}
+
+/* "id quantidade", "id;quantidade" ou "id,quantidade" (CSV). 1 se leu os dois */
+static int ler_linha_entrega(const char *txt, int *id, Quantidade *qtd) {
+    char *fim;
+    long v = strtol(txt, &fim, 10);
+    if (fim == txt || v <= 0 || v > INT32_MAX) return 0;
+    while (*fim == ' ' || *fim == '\t') fim++;
+    if (*fim == ';' || *fim == ',') fim++;
+    if (!qtd_ler(fim, qtd)) return 0;
+    *id = (int)v;
+    return 1;
+}
+
+/*
+ * ADD_ESTOQUE_BULK n | @arquivo.csv: entrada de uma entrega inteira.
+ * Com n, as n linhas seguintes (como no BATCH) trazem "id quantidade";
+ * com @arquivo, cada linha do CSV traz "id,quantidade" (um cabeçalho na
+ * primeira linha é ignorado; linhas vazias e com '#' também). O arquivo
+ * é só um nome dentro de data/: '/', '\' e ".." são recusados.
+ *
+ * Linha com formato inválido ou id fora do catálogo é recusada sozinha e
+ * aparece em "erros"; as demais seguem. As aceitas são ordenadas por id e
+ * as repetidas somadas, então cada ingrediente muda uma vez (um aviso aos
+ * observadores, um registro de journal) e o estoque cresce uma vez só
+ * (est_adicionar_lote). Com --reservas, um total negativo que avançaria
+ * sobre o reservado recusa todas as linhas daquele ingrediente. O journal
+ * da entrega é uma transação e a compactação é conferida uma vez, no fim.
+ */
+static void cmd_add_estoque_bulk(const char *args) {
+    FILE *arq = NULL;
+    int esperadas = 0;
+    if (args[0] == '@') {
+        const char *nome = args + 1;
+        char caminho[256];
+        if (!*nome || strpbrk(nome, "/\\") || strstr(nome, "..") ||
+            snprintf(caminho, sizeof(caminho), "data/%s", nome) >= (int)sizeof(caminho)) {
+            respond_fail("Arquivo da entrega: so o nome de um arquivo em data/");
+            return;
         }
-        else if (!strcmp(cmd, "ADD_ESTOQUE")) {
-            int id; float qtd;
-            if (sscanf(args, "%d %f", &id, &qtd) == 2) cmd_add_estoque(id, qtd);
-            else respond_fail("Formato: id quantidade");
+        arq = fopen(caminho, "r");
+        if (!arq) { respond_fail("Nao foi possivel abrir o arquivo da entrega"); return; }
+    } else if (sscanf(args, "%d", &esperadas) != 1 || esperadas <= 0 || esperadas > ENTREGA_MAX_LINHAS) {
+        respond_fail("Formato: ADD_ESTOQUE_BULK n | @arquivo.csv");
+        return;
+    }
+
+    /* Leitura: as n linhas sao consumidas mesmo se faltar memoria, para o
+       proximo comando nao ser lido como parte da entrega */
+    LinhaEntrega *linhas = NULL;
+    int qtd = 0, cap = 0, num = 0, sem_memoria = 0, demais = 0;
+    char buf[API_MAX_LINHA];
+    while (arq ? fgets(buf, sizeof(buf), arq) != NULL
+               : (num < esperadas && proxima_linha_lote(buf, sizeof(buf)))) {
+        num++;
+        utl_chomp(buf);
+        size_t len = strlen(buf);
+        if (len && buf[len - 1] == '\r') buf[--len] = '\0';
+        const char *txt = buf;
+        while (*txt == ' ' || *txt == '\t') txt++;
+        if (!*txt || *txt == '#') continue;
+
+        int id = 0;
+        Quantidade q = 0;
+        const char *erro = NULL;
+        if (!ler_linha_entrega(txt, &id, &q)) {
+            if (arq && num == 1) continue; /* cabecalho do CSV */
+            erro = "Formato: id quantidade";
+        } else if (!cat_buscar_id(app->cat, id)) {
+            erro = "Ingrediente nao existe no catalogo";
         }
-        else if (!strcmp(cmd, "DEL_ESTOQUE")) {
-            int id; if (sscanf(args, "%d", &id) == 1) cmd_del_estoque(id);
-            else respond_fail("ID invalido");
+
+        if (sem_memoria || demais) continue;
+        if (qtd == ENTREGA_MAX_LINHAS) { demais = 1; continue; }
+        if (qtd == cap) {
+            int nova = cap ? cap * 2 : 64;
+            LinhaEntrega *v = realloc(linhas, sizeof(LinhaEntrega) * (size_t)nova);
+            if (!v) { sem_memoria = 1; continue; }
+            linhas = v;
+            cap = nova;
         }
-        else if (!strcmp(cmd, "ADD_RECEITA")) {
-            char nome[128], preparo[512];
-            if (split_pipe(args, nome, sizeof(nome), preparo, sizeof(preparo)))
-                cmd_add_receita(nome, preparo);
-            else respond_fail("Formato: nome|preparo");
+        linhas[qtd++] = (LinhaEntrega){ num, id, q, erro };
+    }
+    if (arq) fclose(arq);
+
+    EntradaEstoque *entradas = qtd ? malloc(sizeof(EntradaEstoque) * (size_t)qtd) : NULL;
+    char *existia = qtd ? malloc((size_t)qtd) : NULL;
+    if (demais || sem_memoria || (qtd && (!entradas || !existia))) {
+        free(linhas); free(entradas); free(existia);
+        respond_fail(demais ? "Entrega com linhas demais" : "Memoria insuficiente");
+        return;
+    }
+
+    /* Agrupa as aceitas por id: cada grupo vira uma entrada com a soma */
+    if (qtd) qsort(linhas, (size_t)qtd, sizeof(LinhaEntrega), comparar_entrega);
+    int n_entradas = 0, aplicadas = 0;
+    for (int i = 0; i < qtd; ) {
+        if (linhas[i].erro) { i++; continue; }
+        int j = i;
+        Quantidade total = 0;
+        for (; j < qtd && linhas[j].id == linhas[i].id; j++) {
+            total += linhas[j].qtd;
+            if (total > QTD_MAXIMO) total = QTD_MAXIMO;
+            if (total < -QTD_MAXIMO) total = -QTD_MAXIMO;
         }
-        else if (!strcmp(cmd, "DEL_RECEITA")) {
-            int id; if (sscanf(args, "%d", &id) == 1) cmd_del_receita(id);
-            else respond_fail("ID invalido");
+        int id = linhas[i].id;
+        if (total < 0 && modo_reserva && est_disponivel(app->estoque, id) + total < 0) {
+            for (int k = i; k < j; k++) linhas[k].erro = "Quantidade reservada por pedidos na fila";
+        } else {
+            existia[n_entradas] = est_buscar_indice(app->estoque, id) != -1;
+            entradas[n_entradas++] = (EntradaEstoque){ id, total };
+            aplicadas += j - i;
         }
-        else if (!strcmp(cmd, "ADD_ING_RECEITA")) {
-            int id_rec, id_ing; float qtd;
-            if (sscanf(args, "%d %d %f", &id_rec, &id_ing, &qtd) == 3)
-                cmd_add_ing_receita(id_rec, id_ing, qtd);
-            else respond_fail("Formato: id_rec id_ing qtd");
+        i = j;
+    }
+
+    if (!est_adicionar_lote(app->estoque, entradas, n_entradas)) {
+        free(linhas); free(entradas); free(existia);
+        respond_fail("Memoria insuficiente");
+        return;
+    }
+    pers_jrn_transacao_inicio();
+    for (int i = 0; i < n_entradas; i++) {
+        pers_jrn_estoque(app->estoque, entradas[i].id_ingrediente);
+        hist_registrar(&hist, HIST_ESTOQUE, entradas[i].id_ingrediente,
+                       existia[i] ? HIST_ALTEROU : HIST_INSERIU);
+    }
+    pers_jrn_transacao_fim();
+    persistir();
+
+    /* As recusadas pelas reservas entram na ordem das linhas junto com as outras */
+    if (qtd) qsort(linhas, (size_t)qtd, sizeof(LinhaEntrega), comparar_entrega);
+    json_abrir_objeto(&resp);
+    json_campo_bool(&resp, "ok", 1);
+    json_campo_int(&resp, "linhas", qtd);
+    json_campo_int(&resp, "aplicadas", aplicadas);
+    json_campo_int(&resp, "itens", n_entradas);
+    json_chave(&resp, "erros");
+    json_abrir_array(&resp);
+    for (int i = 0; i < qtd && linhas[i].erro; i++) {
+        json_abrir_objeto(&resp);
+        json_campo_int(&resp, "linha", linhas[i].linha);
+        json_campo_str(&resp, "error", linhas[i].erro);
+        json_fechar_objeto(&resp);
+    }
+    json_fechar_array(&resp);
+    json_fechar_objeto(&resp);
+    fim_resposta();
+
+    free(linhas);
+    free(entradas);
+    free(existia);
+}
+
+/* ─── Loop do modo framed ─────────────────────────────────────────────────── */
+
+/* Comandos que leem linhas depois da primeira (proxima_linha_lote) */
+static int comando_com_corpo(const char *linha) {
+    char cmd[32];
+    if (sscanf(linha, "%31s", cmd) != 1) return 0;
+    return !strcmp(cmd, "BATCH") || !strcmp(cmd, "ADD_ESTOQUE_BULK");
+}
+
+static int ler_exato(void *buf, size_t n) {
+    return fread(buf, 1, n, stdin) == n;
+}
+
+static void loop_framed() {
+    unsigned char cab[8];
+    char *payload = NULL;
+    size_t cap = 0;
+
+#ifdef _WIN32
+    _setmode(_fileno(stdin), _O_BINARY);
+    _setmode(_fileno(stdout), _O_BINARY);
+#endif
+
+    while (ler_exato(cab, sizeof(cab))) {
+        id_requisicao = ler_u32_be(cab);
+        uint32_t len = ler_u32_be(cab + 4);
+
+        if (len > FRAME_MAX_PAYLOAD) {
+            /* Descarta o payload para não perder o alinhamento dos frames */
+            char lixo[4096];
+            uint32_t resta = len;
+            while (resta > 0) {
+                size_t n = resta < sizeof(lixo) ? resta : sizeof(lixo);
+                if (!ler_exato(lixo, n)) break;
+                resta -= (uint32_t)n;
+            }
+            respond_fail("Frame maior que o limite");
+            continue;
         }
-        else if (!strcmp(cmd, "ADD_PEDIDO")) {
-            int id; if (sscanf(args, "%d", &id) == 1) cmd_add_pedido(id);
-            else respond_fail("ID invalido");
+        if (len + 1 > cap) {
+            char *novo = realloc(payload, len + 1);
+            if (!novo) break;
+            payload = novo;
+            cap = len + 1;
         }
-        else if (!strcmp(cmd, "DEL_PEDIDO")) {
-            int id; if (sscanf(args, "%d", &id) == 1) cmd_del_pedido(id);
-            else respond_fail("ID invalido");
+        if (!ler_exato(payload, len)) break;
+        payload[len] = '\0';
+
+        /* Primeira linha = comando; o resto (se houver) = linhas do BATCH ou
+           do ADD_ESTOQUE_BULK. Em qualquer outro comando, linhas a mais seriam
+           um texto com quebra de linha cortado em silêncio: o frame é recusado
+           (os snapshots são por linha e não guardariam a quebra) */
+        char *nl = strchr(payload, '\n');
+        if (nl) { *nl = '\0'; corpo_lote = nl + 1; }
+        utl_chomp(payload);
+
+        int continuar = 1;
+        if (!strlen(payload)) respond_fail("Comando vazio");
+        else if (corpo_lote && *corpo_lote && !comando_com_corpo(payload))
+            respond_fail("Quebra de linha nao permitida nos campos do comando");
+        else continuar = executar_comando(payload);
+        corpo_lote = NULL;
+        if (!continuar) break;
+    }
+    free(payload);
+}
+
+/* ─── Main loop ───────────────────────────────────────────────────────────── */
+int main(int argc, char **argv) {
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--framed")) modo_framed = 1;
+        else if (!strcmp(argv[i], "--reservas")) modo_reserva = 1;
+        else if (!strcmp(argv[i], "--pular-bloqueados")) modo_pular = 1;
+        else if (!strcmp(argv[i], "--duas-fases")) modo_duas_fases = 1;
+    }
+    if (modo_framed) sep_campos = '\x1f';
+
+    app = app_criar();
+    if (!app) { fprintf(stderr, "Erro ao inicializar\n"); return 1; }
+    ligar_espera(app);
+
+    /* Snapshot (binário ou texto) + cauda do journal; depois grava um snapshot limpo */
+    if (pers_carregar_tudo(app->cat, app->banco, app->estoque, app->fila) > 0)
+        pers_compactar(app->cat, app->banco, app->estoque, app->fila);
+    if (!pers_journal_abrir()) fprintf(stderr, "Aviso: journal indisponivel\n");
+    if (modo_reserva) reservar_fila();
+
+    /* Respostas saem via write() direto; o stdout sem buffer só garante que
+       algum printf perdido dos módulos não fique preso e se misture depois */
+    setvbuf(stdout, NULL, _IONBF, 0);
+    json_iniciar(&resp);
+    inicio_resposta();
+    hist_inicializar(&hist);
+
+    if (modo_framed) {
+        loop_framed();
+    } else {
+        char linha[API_MAX_LINHA];
+        while (fgets(linha, sizeof(linha), stdin)) {
+            utl_chomp(linha);
+            if (!strlen(linha)) continue;
+            if (!executar_comando(linha)) break;
         }
-        else if (!strcmp(cmd, "PROCESSAR_PEDIDO")) cmd_processar_pedido();
-        else if (!strcmp(cmd, "QUIT"))             break;
-        else respond_fail("Comando desconhecido");
     }
 
+    json_liberar(&resp);
+    pers_journal_fechar();
     app_destruir(app);
     return 0;
 }
@@ -5,16 +5,24 @@ AppContext* app_criar() {
     AppContext* app = (AppContext*) malloc(sizeof(AppContext));
     if (!app) return NULL;
 
-    if (!cat_inicializar(&app->cat)) {
+    arena_iniciar(&app->strings);
+    if (!cat_inicializar(&app->cat, &app->strings)) {
         free(app);
         return NULL;
     }
 
-    app->banco = rec_inicializar();
+    pool_iniciar(&app->pool_pedidos, "pedidos", sizeof(NoPedido));
+    pool_iniciar(&app->pool_rollback, "rollback", sizeof(NoRollback));
+
+    app->banco = rec_inicializar(&app->strings);
     app->estoque = est_inicializar();
-    app->fila = ped_inicializar();
+    app->fila = app->banco ? ped_inicializar(app->banco, &app->pool_pedidos) : NULL;
+    app->rollback = rb_criar(&app->pool_rollback);
+    app->producao = NULL;
+    if (app->banco && app->estoque)
+        app->producao = prd_criar(app->banco, app->estoque);
 
-    if (!app->banco || !app->estoque || !app->fila) {
+    if (!app->banco || !app->estoque || !app->fila || !app->rollback || !app->producao) {
         app_destruir(app);
         return NULL;
     }
@@ -22,11 +30,28 @@ AppContext* app_criar() {
     return app;
 }
 
+void app_compactar_textos(AppContext* app) {
+    if (!app) return;
+    ArenaStrings nova;
+    arena_iniciar(&nova);
+    if (!cat_recopiar_textos(app->cat, &nova) || !rec_recopiar_textos(app->banco, &nova)) {
+        arena_absorver(&app->strings, &nova);
+        return;
+    }
+    arena_liberar(&app->strings);
+    app->strings = nova; // cat->arena e banco->arena apontam para app->strings
+}
+
 void app_destruir(AppContext* app) {
     if (!app) return;
     if (app->cat) cat_liberar(app->cat);
     if (app->banco) rec_liberar_tudo(app->banco);
     if (app->estoque) est_liberar(app->estoque);
     if (app->fila) ped_liberar(app->fila);
+    if (app->rollback) rb_liberar(app->rollback);
+    if (app->producao) prd_liberar(app->producao);
+    pool_liberar(&app->pool_pedidos);
+    pool_liberar(&app->pool_rollback);
+    arena_liberar(&app->strings);
     free(app);
 }
@@ -5,15 +5,37 @@
 #include "core/receitas.h"
 #include "core/estoque.h"
 #include "core/pedidos.h"
+#include "core/producao.h"
+#include "core/rollback.h"
+#include "core/pool.h"
+#include "core/arena.h"
 
 typedef struct {
     CatalogoIngredientes* cat;
     BancoReceitas* banco;
     Estoque* estoque;
     FilaPedidos* fila;
+    CacheProducao* producao; // porções produzíveis por receita (observa o estoque)
+    PilhaRollback* rollback; // pilha reaproveitada a cada pedido processado
+
+    /* Nós das listas encadeadas (liberados depois das estruturas que os usam) */
+    PoolFixo pool_pedidos;
+    PoolFixo pool_rollback;
+
+    /* Nomes, unidades e modos de preparo do catálogo e das receitas */
+    ArenaStrings strings;
 } AppContext;
 
 AppContext* app_criar();
 void app_destruir(AppContext* app);
 
+/*
+ * A arena só cresce: renomear, editar o modo de preparo ou remover deixa
+ * o texto antigo para trás. Aqui os textos vivos do catálogo e das
+ * receitas são copiados para uma arena nova e a antiga é liberada.
+ * Faltando memória no meio, a arena nova é absorvida pela antiga (nada
+ * fica inválido, só não compacta). Chamado junto com pers_compactar.
+ */
+void app_compactar_textos(AppContext* app);
+
 #endif
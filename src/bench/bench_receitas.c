@@ -0,0 +1,152 @@
+/*
+ * bench_receitas.c — Mede o vetor ordenado de ingredientes (ingredientes.c)
+ * contra a lista encadeada que as receitas usavam antes.
+ *
+ * Uso: bench_receitas [qtd_receitas] [ingredientes_por_receita]
+ *
+ * Para cada representação: monta o banco (insere com atualização de
+ * repetidos, como o ing_adicionar), faz buscas por id e percorre todas as
+ * receitas somando as quantidades (o que o processamento e a listagem fazem).
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "core/ingredientes.h"
+
+#define ID_MAXIMO 1000          /* ids de ingrediente sorteados em 1..ID_MAXIMO */
+#define BUSCAS_POR_RECEITA 64
+#define PASSADAS 50
+#define PASSADAS_BUSCA 10
+
+/* ─── Referência: a lista encadeada antiga ───────────────────────────────── */
+
+typedef struct NoLista {
+    int id_ingrediente;
+    Quantidade quantidade;
+    struct NoLista* prox;
+} NoLista;
+
+static NoLista* lista_buscar(NoLista* cabeca, int id) {
+    while (cabeca && cabeca->id_ingrediente != id) cabeca = cabeca->prox;
+    return cabeca;
+}
+
+static int lista_adicionar(NoLista** cabeca, int id, Quantidade qtd) {
+    NoLista* n = lista_buscar(*cabeca, id);
+    if (n) { n->quantidade = qtd; return 1; }
+    n = malloc(sizeof(NoLista));
+    if (!n) return 0;
+    n->id_ingrediente = id;
+    n->quantidade = qtd;
+    n->prox = *cabeca;
+    *cabeca = n;
+    return 1;
+}
+
+static void lista_liberar(NoLista** cabeca) {
+    while (*cabeca) {
+        NoLista* t = *cabeca;
+        *cabeca = t->prox;
+        free(t);
+    }
+}
+
+/* ─── Utilitários ─────────────────────────────────────────────────────────── */
+
+/* xorshift32: mesma sequência em qualquer plataforma */
+static unsigned int semente;
+static int sortear(int max) {
+    semente ^= semente << 13;
+    semente ^= semente >> 17;
+    semente ^= semente << 5;
+    return (int)(semente % (unsigned int)max) + 1;
+}
+
+static double segundos(clock_t ini) {
+    return (double)(clock() - ini) / CLOCKS_PER_SEC;
+}
+
+static void relatar(const char* etapa, double t_lista, double t_vetor) {
+    printf("  %-10s lista %9.4f s   vetor %9.4f s   ganho %6.2fx\n",
+           etapa, t_lista, t_vetor, t_vetor > 0 ? t_lista / t_vetor : 0.0);
+}
+
+/* ─── Main ────────────────────────────────────────────────────────────────── */
+int main(int argc, char** argv) {
+    int qtd_receitas = argc > 1 ? atoi(argv[1]) : 20000;
+    int por_receita = argc > 2 ? atoi(argv[2]) : 24;
+    if (qtd_receitas <= 0 || por_receita <= 0) {
+        fprintf(stderr, "Uso: %s [qtd_receitas] [ingredientes_por_receita]\n", argv[0]);
+        return 1;
+    }
+
+    NoLista** listas = calloc((size_t)qtd_receitas, sizeof(NoLista*));
+    VetorIngredientes* vetores = malloc(sizeof(VetorIngredientes) * (size_t)qtd_receitas);
+    if (!listas || !vetores) { fprintf(stderr, "Memoria insuficiente\n"); return 1; }
+    for (int i = 0; i < qtd_receitas; i++) ing_inicializar(&vetores[i]);
+
+    printf("%d receitas x %d ingredientes (ids 1..%d)\n", qtd_receitas, por_receita, ID_MAXIMO);
+
+    /* Montagem: as duas recebem a mesma sequência de inserções */
+    clock_t ini = clock();
+    semente = 2463534242u;
+    for (int i = 0; i < qtd_receitas; i++)
+        for (int k = 0; k < por_receita; k++)
+            lista_adicionar(&listas[i], sortear(ID_MAXIMO), (Quantidade)k);
+    double t_lista = segundos(ini);
+
+    ini = clock();
+    semente = 2463534242u;
+    for (int i = 0; i < qtd_receitas; i++)
+        for (int k = 0; k < por_receita; k++)
+            ing_adicionar(&vetores[i], sortear(ID_MAXIMO), (Quantidade)k);
+    relatar("montar", t_lista, segundos(ini));
+
+    /* Busca por id: sorteados em 1..ID_MAXIMO, então parte não está na receita.
+       Repetida PASSADAS_BUSCA vezes: uma passada só dura poucos ms e o ruído
+       do relógio decidia o resultado */
+    long achados_lista = 0, achados_vetor = 0;
+    ini = clock();
+    for (int p = 0; p < PASSADAS_BUSCA; p++) {
+        semente = 88675123u;
+        for (int i = 0; i < qtd_receitas; i++)
+            for (int k = 0; k < BUSCAS_POR_RECEITA; k++)
+                if (lista_buscar(listas[i], sortear(ID_MAXIMO))) achados_lista++;
+    }
+    t_lista = segundos(ini);
+
+    ini = clock();
+    for (int p = 0; p < PASSADAS_BUSCA; p++) {
+        semente = 88675123u;
+        for (int i = 0; i < qtd_receitas; i++)
+            for (int k = 0; k < BUSCAS_POR_RECEITA; k++)
+                if (ing_buscar(&vetores[i], sortear(ID_MAXIMO))) achados_vetor++;
+    }
+    relatar("buscar", t_lista, segundos(ini));
+
+    /* Percorrer tudo, várias vezes */
+    double soma_lista = 0, soma_vetor = 0;
+    ini = clock();
+    for (int p = 0; p < PASSADAS; p++)
+        for (int i = 0; i < qtd_receitas; i++)
+            for (NoLista* n = listas[i]; n; n = n->prox) soma_lista += n->quantidade;
+    t_lista = segundos(ini);
+
+    ini = clock();
+    for (int p = 0; p < PASSADAS; p++)
+        for (int i = 0; i < qtd_receitas; i++)
+            for (int k = 0; k < vetores[i].qtd; k++) soma_vetor += vetores[i].itens[k].quantidade;
+    relatar("percorrer", t_lista, segundos(ini));
+
+    /* Confere que as duas representações guardaram o mesmo conteúdo */
+    int ok = achados_lista == achados_vetor && soma_lista == soma_vetor;
+    printf("  conferencia: %s\n", ok ? "ok" : "DIVERGENTE");
+
+    for (int i = 0; i < qtd_receitas; i++) {
+        lista_liberar(&listas[i]);
+        ing_liberar(&vetores[i]);
+    }
+    free(listas);
+    free(vetores);
+    return ok ? 0 : 1;
+}
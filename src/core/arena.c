@@ -0,0 +1,177 @@
+#include "arena.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* Cabecalho de cada bloco; o texto vem logo depois (strings nao precisam de alinhamento) */
+typedef struct BlocoArena {
+    struct BlocoArena* prox;
+    size_t usado;
+    size_t capacidade;
+    char dados[];
+} BlocoArena;
+
+#define TABELA_INICIAL 256
+
+void arena_iniciar(ArenaStrings* a) {
+    if (!a) return;
+    a->blocos = NULL;
+    a->tabela = NULL;
+    a->cap_tabela = 0;
+    a->stats = (ArenaStats){0, 0, 0, 0, 0};
+}
+
+void arena_liberar(ArenaStrings* a) {
+    if (!a) return;
+    BlocoArena* b = a->blocos;
+    while (b) {
+        BlocoArena* prox = b->prox;
+        free(b);
+        b = prox;
+    }
+    free(a->tabela);
+    arena_iniciar(a);
+}
+
+void arena_limpar(ArenaStrings* a) {
+    if (!a) return;
+    BlocoArena* primeiro = a->blocos;
+    if (!primeiro) return;
+    BlocoArena* b = primeiro->prox;
+    while (b) {
+        BlocoArena* prox = b->prox;
+        free(b);
+        b = prox;
+    }
+    primeiro->prox = NULL;
+    primeiro->usado = 0;
+    if (a->tabela) memset(a->tabela, 0, sizeof(char*) * a->cap_tabela);
+    a->stats = (ArenaStats){1, 0, 0, 0, 0};
+}
+
+/*
+    arena_absorver
+        - Os blocos da origem entram logo atras do bloco atual do destino,
+          que continua recebendo as proximas strings.
+        - Usado pela carga paralela: cada thread escreve numa arena propria
+          e o resultado vai para a arena do AppContext depois do join.
+ */
+void arena_absorver(ArenaStrings* destino, ArenaStrings* origem) {
+    if (!destino || !origem || destino == origem || !origem->blocos) return;
+    BlocoArena* ultimo = origem->blocos;
+    while (ultimo->prox) ultimo = ultimo->prox;
+    BlocoArena* atual = destino->blocos;
+    if (atual) {
+        ultimo->prox = atual->prox;
+        atual->prox = origem->blocos;
+    } else {
+        destino->blocos = origem->blocos;
+    }
+    destino->stats.blocos += origem->stats.blocos;
+    destino->stats.bytes += origem->stats.bytes;
+    destino->stats.copias += origem->stats.copias;
+    destino->stats.reaproveitadas += origem->stats.reaproveitadas;
+    free(origem->tabela);
+    arena_iniciar(origem);
+}
+
+/*
+    reservar
+        - n bytes contiguos no bloco atual; se nao cabem, abre um bloco
+          novo na frente da lista (o resto do anterior e perdido).
+        - Uma string maior que um quarto do bloco ganha um bloco sob medida,
+          encaixado atras do atual, que continua recebendo as pequenas.
+ */
+static char* reservar(ArenaStrings* a, size_t n) {
+    BlocoArena* atual = a->blocos;
+    if (atual && atual->capacidade - atual->usado >= n) {
+        char* p = atual->dados + atual->usado;
+        atual->usado += n;
+        return p;
+    }
+
+    int sob_medida = n > ARENA_TAM_BLOCO / 4;
+    size_t cap = sob_medida ? n : ARENA_TAM_BLOCO;
+    BlocoArena* novo = malloc(sizeof(BlocoArena) + cap);
+    if (!novo) return NULL;
+    novo->capacidade = cap;
+    novo->usado = n;
+    if (sob_medida && atual) {
+        novo->prox = atual->prox;
+        atual->prox = novo;
+    } else {
+        novo->prox = atual;
+        a->blocos = novo;
+    }
+    a->stats.blocos++;
+    return novo->dados;
+}
+
+static char* copiar_n(ArenaStrings* a, const char* s, size_t len) {
+    char* p = reservar(a, len + 1);
+    if (!p) return NULL;
+    memcpy(p, s, len + 1);
+    a->stats.bytes += len + 1;
+    a->stats.copias++;
+    return p;
+}
+
+char* arena_copiar(ArenaStrings* a, const char* s) {
+    if (!a || !s) return NULL;
+    return copiar_n(a, s, strlen(s));
+}
+
+/* FNV-1a de 32 bits */
+static size_t hash_texto(const char* s) {
+    unsigned long h = 2166136261UL;
+    for (; *s; s++) {
+        h ^= (unsigned char)*s;
+        h = (h * 16777619UL) & 0xFFFFFFFFUL;
+    }
+    return (size_t)h;
+}
+
+/* Dobra a tabela de internadas e reposiciona os textos (eles mesmos nao mudam de lugar) */
+static int crescer_tabela(ArenaStrings* a) {
+    size_t nova_cap = a->cap_tabela ? a->cap_tabela * 2 : TABELA_INICIAL;
+    char** nova = calloc(nova_cap, sizeof(char*));
+    if (!nova) return 0;
+    for (size_t i = 0; i < a->cap_tabela; i++) {
+        char* s = a->tabela[i];
+        if (!s) continue;
+        size_t p = hash_texto(s) & (nova_cap - 1);
+        while (nova[p]) p = (p + 1) & (nova_cap - 1);
+        nova[p] = s;
+    }
+    free(a->tabela);
+    a->tabela = nova;
+    a->cap_tabela = nova_cap;
+    return 1;
+}
+
+/*
+    arena_internar
+        - Strings com ARENA_INTERNAR_MAX bytes ou mais (ex: modo de preparo)
+          raramente se repetem: so sao copiadas.
+        - Sem memoria para crescer a tabela, copia sem deduplicar.
+ */
+char* arena_internar(ArenaStrings* a, const char* s) {
+    if (!a || !s) return NULL;
+    size_t len = strlen(s);
+    if (len >= ARENA_INTERNAR_MAX) return copiar_n(a, s, len);
+    if ((a->stats.internadas + 1) * 10 > a->cap_tabela * 7 && !crescer_tabela(a))
+        return copiar_n(a, s, len);
+
+    size_t p = hash_texto(s) & (a->cap_tabela - 1);
+    while (a->tabela[p]) {
+        if (strcmp(a->tabela[p], s) == 0) {
+            a->stats.reaproveitadas++;
+            return a->tabela[p];
+        }
+        p = (p + 1) & (a->cap_tabela - 1);
+    }
+    char* copia = copiar_n(a, s, len);
+    if (!copia) return NULL;
+    a->tabela[p] = copia;
+    a->stats.internadas++;
+    return copia;
+}
@@ -0,0 +1,55 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+/*
+ * Arena de strings: as copias sao escritas em sequencia dentro de blocos
+ * grandes (ARENA_TAM_BLOCO), em vez de um malloc por string. Nada e
+ * liberado sozinho; tudo volta ao sistema em arena_liberar (ou e
+ * reaproveitado depois de arena_limpar).
+ *
+ * Strings curtas (ate ARENA_INTERNAR_MAX bytes, ex: unidades e nomes)
+ * sao internadas: uma tabela hash guarda cada texto uma vez e quem pede
+ * o mesmo texto recebe o mesmo ponteiro. Por isso o que vem da arena e
+ * so leitura e nunca vai para free().
+ *
+ * Os modulos que usam arena aceitam um ponteiro NULL ("sem arena") e caem
+ * em utl_strdup/free, como os pools.
+ */
+
+#define ARENA_TAM_BLOCO    (64 * 1024)
+#define ARENA_INTERNAR_MAX 64
+
+typedef struct {
+    size_t blocos;          // blocos pedidos ao malloc
+    size_t bytes;           // bytes de texto gravados (com o '\0')
+    size_t copias;          // strings gravadas
+    size_t internadas;      // textos distintos na tabela
+    size_t reaproveitadas;  // pedidos atendidos por um texto ja internado
+} ArenaStats;
+
+typedef struct {
+    void* blocos;           // lista encadeada, o bloco atual na frente
+    char** tabela;          // internadas (enderecamento aberto, NULL = vazio)
+    size_t cap_tabela;
+    ArenaStats stats;
+} ArenaStrings;
+
+void arena_iniciar(ArenaStrings* a);
+// Devolve tudo ao sistema (as strings entregues ficam invalidas)
+void arena_liberar(ArenaStrings* a);
+// Esquece as strings mas guarda o primeiro bloco para reaproveitar
+void arena_limpar(ArenaStrings* a);
+
+// Passa os blocos de 'origem' para 'destino' (os textos nao mudam de lugar
+// e passam a ser liberados com o destino); 'origem' fica vazia. Os textos
+// internados na origem nao entram na tabela do destino
+void arena_absorver(ArenaStrings* destino, ArenaStrings* origem);
+
+// Copia de s na arena (sem deduplicar). NULL se faltou memoria
+char* arena_copiar(ArenaStrings* a, const char* s);
+// Como arena_copiar, mas strings curtas iguais saem do mesmo ponteiro
+char* arena_internar(ArenaStrings* a, const char* s);
+
+#endif
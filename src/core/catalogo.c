@@ -3,6 +3,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
+#include <ctype.h>
 
 #define CATALOGO_INITIAL_CAPACITY 8
 
@@ -17,8 +18,12 @@
         - Inicializa a estrutura CatalogoIngredientes.
         - Aloca array inicial com capacidade CATALOGO_INITIAL_CAPACITY.
         - Inicializa contadores e o próximo id (prox_id começa em 1).
+        - Nomes e unidades passam a vir da arena (se houver).
+        - Cria o índice hash id -> posição usado por cat_buscar_id,
+          o array ordenado de nomes e a pilha de slots livres (mesma
+          capacidade de itens).
  */
-int cat_inicializar(CatalogoIngredientes **cat) {
+int cat_inicializar(CatalogoIngredientes **cat, ArenaStrings *arena) {
     if (!cat) return 0;
     *cat = malloc(sizeof(CatalogoIngredientes));
     if (!(*cat)) return 0;
@@ -28,27 +33,213 @@ int cat_inicializar(CatalogoIngredientes **cat) {
         free(*cat);
         return 0;
     }
+    (*cat)->por_nome = malloc(sizeof(EntradaNome) * CATALOGO_INITIAL_CAPACITY);
+    (*cat)->livres = malloc(sizeof(size_t) * CATALOGO_INITIAL_CAPACITY);
+    if (!(*cat)->por_nome || !(*cat)->livres || !hsh_inicializar(&(*cat)->por_id, CATALOGO_INITIAL_CAPACITY)) {
+        free((*cat)->livres);
+        free((*cat)->por_nome);
+        free((*cat)->itens);
+        free(*cat);
+        return 0;
+    }
     (*cat)->qtd_atual = 0;
+    (*cat)->qtd_nomes = 0;
+    (*cat)->qtd_slots = 0;
+    (*cat)->qtd_livres = 0;
     (*cat)->capacidade = CATALOGO_INITIAL_CAPACITY;
     (*cat)->prox_id = 1;
+    (*cat)->arena = arena;
     return 1;
 }
 
 /* 
     ensure_capacity
-        - Verifica se há espaço no array para pelo menos mais 1 item.
-        - Se não houver, realoca o array dobrando a capacidade.
+        - Verifica se há espaço no array para pelo menos mais 1 slot novo.
+        - Se não houver, realoca o array (o índice de nomes e a pilha de
+          livres junto) dobrando a capacidade.
  */
 static int ensure_capacity(CatalogoIngredientes *cat) {
-    if (cat->qtd_atual < cat->capacidade) return 1;
+    if (cat->qtd_slots < cat->capacidade) return 1;
     size_t newcap = cat->capacidade * 2;
     IngredienteBase *newitems = realloc(cat->itens, sizeof(IngredienteBase) * newcap);
     if (!newitems) return 0;
     cat->itens = newitems;
+    EntradaNome *newnomes = realloc(cat->por_nome, sizeof(EntradaNome) * newcap);
+    if (!newnomes) return 0;
+    cat->por_nome = newnomes;
+    size_t *newlivres = realloc(cat->livres, sizeof(size_t) * newcap);
+    if (!newlivres) return 0;
+    cat->livres = newlivres;
     cat->capacidade = newcap;
     return 1;
 }
 
+/* 
+    copiar_texto / soltar_texto
+        - Com arena, a cópia é internada (unidades e nomes repetidos
+          dividem o mesmo ponteiro) e nunca é liberada individualmente.
+        - Sem arena, utl_strdup/free como antes.
+ */
+static char *copiar_texto(const CatalogoIngredientes *cat, const char *s) {
+    return cat->arena ? arena_internar(cat->arena, s) : utl_strdup(s);
+}
+
+static void soltar_texto(const CatalogoIngredientes *cat, char *s) {
+    if (!cat->arena) free(s);
+}
+
+/* 
+    chave_na_arena
+        - Nome em minúsculas internado em 'arena': cadastrar ou renomear para
+          uma chave que já existe (inclusive a de uma lápide) não grava nada.
+        - Nomes longos, que a arena não interna, são copiados e convertidos
+          no lugar.
+ */
+static char *chave_na_arena(ArenaStrings *arena, const char *nome) {
+    char buf[ARENA_INTERNAR_MAX];
+    size_t len = strlen(nome);
+    if (len < sizeof(buf)) {
+        for (size_t i = 0; i <= len; i++) buf[i] = (char)tolower((unsigned char)nome[i]);
+        return arena_internar(arena, buf);
+    }
+    char *chave = arena_copiar(arena, nome);
+    if (chave)
+        for (char *p = chave; *p; p++) *p = (char)tolower((unsigned char)*p);
+    return chave;
+}
+
+/* Chave do índice de nomes (nome em minúsculas) */
+static char *copiar_chave(const CatalogoIngredientes *cat, const char *nome) {
+    return cat->arena ? chave_na_arena(cat->arena, nome) : utl_str_minusculas(nome);
+}
+
+/* 
+    comparar_chave
+        - Compara uma chave do índice (já em minúsculas) com um texto
+          qualquer, convertendo o texto para minúsculas durante a
+          comparação (sem alocar cópia).
+ */
+static int comparar_chave(const char *chave, const char *texto) {
+    for (;; chave++, texto++) {
+        int a = (unsigned char)*chave;
+        int b = tolower((unsigned char)*texto);
+        if (a != b || a == 0) return a - b;
+    }
+}
+
+/* Retorna 1 se a chave começa com o prefixo (prefixo comparado em minúsculas) */
+static int chave_comeca_com(const char *chave, const char *prefixo) {
+    for (; *prefixo; chave++, prefixo++) {
+        if ((unsigned char)*chave != tolower((unsigned char)*prefixo)) return 0;
+    }
+    return 1;
+}
+
+/* 
+    nome_lower_bound
+        - Busca binária: primeira posição cuja chave é >= texto. Pode
+          cair numa lapide; quem varre a partir daqui pula as de id 0.
+ */
+static size_t nome_lower_bound(const CatalogoIngredientes *cat, const char *texto) {
+    size_t ini = 0, fim = cat->qtd_nomes;
+    while (ini < fim) {
+        size_t meio = ini + (fim - ini) / 2;
+        if (comparar_chave(cat->por_nome[meio].chave, texto) < 0) ini = meio + 1;
+        else fim = meio;
+    }
+    return ini;
+}
+
+/* 
+    compactar_nomes
+        - Tira as lapides do índice de nomes (uma passada, a ordem se
+          mantém) e libera as chaves delas.
+ */
+static void compactar_nomes(CatalogoIngredientes *cat) {
+    size_t n = 0;
+    for (size_t i = 0; i < cat->qtd_nomes; i++) {
+        if (cat->por_nome[i].id == 0) soltar_texto(cat, cat->por_nome[i].chave);
+        else                          cat->por_nome[n++] = cat->por_nome[i];
+    }
+    cat->qtd_nomes = n;
+}
+
+/* 
+    indexar_nome
+        - Insere (chave, id) na posição ordenada do índice de nomes.
+        - Se o índice encheu de lapides, compacta antes: depois disso sobra
+          espaço, porque ensure_capacity mantém capacidade > itens vivos.
+ */
+static void indexar_nome(CatalogoIngredientes *cat, char *chave, int id) {
+    if (cat->qtd_nomes == cat->capacidade) compactar_nomes(cat);
+    size_t ini = 0, fim = cat->qtd_nomes;
+    while (ini < fim) {
+        size_t meio = ini + (fim - ini) / 2;
+        int c = strcmp(cat->por_nome[meio].chave, chave);
+        if (c < 0 || (c == 0 && cat->por_nome[meio].id < id)) ini = meio + 1;
+        else fim = meio;
+    }
+    memmove(&cat->por_nome[ini + 1], &cat->por_nome[ini], sizeof(EntradaNome) * (cat->qtd_nomes - ini));
+    cat->por_nome[ini].chave = chave;
+    cat->por_nome[ini].id = id;
+    cat->qtd_nomes++;
+}
+
+/* 
+    desindexar_nome
+        - Marca a entrada (nome, id) como lapide, sem deslocar as seguintes.
+        - Quando as lapides passam do número de itens vivos, compacta; o
+          custo da compactação se divide entre as remoções que a causaram.
+ */
+static void desindexar_nome(CatalogoIngredientes *cat, const char *nome, int id) {
+    size_t i = nome_lower_bound(cat, nome);
+    for (; i < cat->qtd_nomes && comparar_chave(cat->por_nome[i].chave, nome) == 0; i++) {
+        if (cat->por_nome[i].id == id) {
+            cat->por_nome[i].id = 0;
+            break;
+        }
+    }
+    if (cat->qtd_nomes - cat->qtd_atual > cat->qtd_atual) compactar_nomes(cat);
+}
+
+/* 
+    inserir_item
+        - Grava (id, nome, unidade) num slot com lapide (o último liberado)
+          ou, se não houver, no fim do array; registra o item no índice
+          hash e no índice de nomes.
+        - Um slot novo começa na geração 0; um reaproveitado mantém a sua.
+ */
+static int inserir_item(CatalogoIngredientes *cat, int id, const char *nome, const char *unidade) {
+    size_t slot;
+    if (cat->qtd_livres > 0) {
+        slot = cat->livres[cat->qtd_livres - 1];
+    } else {
+        if (!ensure_capacity(cat)) return 0;
+        slot = cat->qtd_slots;
+        cat->itens[slot].geracao = 0;
+    }
+
+    IngredienteBase *it = &cat->itens[slot];
+    char *n = copiar_texto(cat, nome);
+    char *u = copiar_texto(cat, unidade ? unidade : "");
+    char *chave = copiar_chave(cat, nome);
+    
+    if (!n || !u || !chave || !hsh_inserir(&cat->por_id, id, (int)slot)) {
+        soltar_texto(cat, n);
+        soltar_texto(cat, u);
+        soltar_texto(cat, chave);
+        return 0;
+    }
+    it->id = id;
+    it->nome = n;
+    it->unidade = u;
+    if (slot == cat->qtd_slots) cat->qtd_slots++;
+    else                        cat->qtd_livres--;
+    cat->qtd_atual++;
+    indexar_nome(cat, chave, id);
+    return id;
+}
+
 /* 
     cat_cadastrar
         - Adiciona um novo item (nome, unidade) ao catálogo.
@@ -56,50 +247,104 @@ static int ensure_capacity(CatalogoIngredientes *cat) {
           como cópias alocadas dinamicamente.
  */
 int cat_cadastrar(CatalogoIngredientes *cat, const char *nome, const char *unidade) {
-    if (!cat || !nome) return 0;
-    if (!ensure_capacity(cat)) return 0;
-    
-    int id = cat->prox_id++;
-    IngredienteBase *it = &cat->itens[cat->qtd_atual];
-    it->id = id;
-    it->nome = utl_strdup(nome);
-    it->unidade = utl_strdup(unidade ? unidade : "");
-    
-    if (!it->nome || !it->unidade) {
-        free(it->nome);
-        free(it->unidade);
-        return 0;
-    }
-    cat->qtd_atual++;
+    if (!cat || !nome || cat->prox_id > CAT_ID_MAXIMO) return 0;
+    int id = inserir_item(cat, cat->prox_id, nome, unidade);
+    if (id) cat->prox_id++;
+    return id;
+}
+
+/* 
+    cat_cadastrar_com_id
+        - Usado pela persistência: mantém o id gravado no arquivo.
+        - Recusa ids repetidos, ids <= 0 (que marcam lapide) e ids acima
+          de CAT_ID_MAXIMO, e ajusta prox_id para nunca colidir.
+ */
+int cat_cadastrar_com_id(CatalogoIngredientes *cat, int id, const char *nome, const char *unidade) {
+    if (!cat || !nome || id <= 0 || id > CAT_ID_MAXIMO) return 0;
+    if (hsh_buscar(&cat->por_id, id) != -1) return 0;
+    if (!inserir_item(cat, id, nome, unidade)) return 0;
+    if (id >= cat->prox_id) cat->prox_id = id + 1;
     return id;
 }
 
 /* 
     cat_buscar_id
-        - Busca linear pelo item com o id especificado.
+        - Consulta o índice hash id -> posição (O(1) em média).
         - Retorna ponteiro para o item ou NULL se não encontrado.
  */
 IngredienteBase *cat_buscar_id(const CatalogoIngredientes *cat, int id) {
     if (!cat) return NULL;
-    for (size_t i = 0; i < cat->qtd_atual; ++i) {
-        if (cat->itens[i].id == id) return &cat->itens[i];
+    int idx = hsh_buscar(&cat->por_id, id);
+    return idx == -1 ? NULL : &cat->itens[idx];
+}
+
+Referencia cat_referencia(const CatalogoIngredientes *cat, int id) {
+    Referencia ref = { -1, 0 };
+    int idx = cat ? hsh_buscar(&cat->por_id, id) : -1;
+    if (idx != -1) {
+        ref.slot = idx;
+        ref.geracao = cat->itens[idx].geracao;
     }
-    return NULL;
+    return ref;
+}
+
+/* 
+    cat_resolver
+        - A referência vale enquanto o slot não passou por uma remoção:
+          lapide ou geração diferente = item removido (ou trocado).
+ */
+IngredienteBase *cat_resolver(const CatalogoIngredientes *cat, Referencia ref) {
+    if (!cat || ref.slot < 0 || (size_t)ref.slot >= cat->qtd_slots) return NULL;
+    IngredienteBase *it = &cat->itens[ref.slot];
+    return (it->id != 0 && it->geracao == ref.geracao) ? it : NULL;
 }
 
 /* 
     cat_buscar_nome
         - Busca id de um item com nome exatamente igual (strcmp).
+        - Usa o índice de nomes: a busca binária acha o bloco de nomes
+          iguais sem diferenciar maiúsculas, e só nele roda o strcmp.
         - Retorna id (>0) se encontrado, ou -1 se não achar.
  */
 int cat_buscar_nome(const CatalogoIngredientes *cat, const char *nome) {
     if (!cat || !nome) return -1;
-    for (size_t i = 0; i < cat->qtd_atual; ++i) {
-        if (strcmp(cat->itens[i].nome, nome) == 0) return cat->itens[i].id;
+    size_t i = nome_lower_bound(cat, nome);
+    for (; i < cat->qtd_nomes && comparar_chave(cat->por_nome[i].chave, nome) == 0; ++i) {
+        if (cat->por_nome[i].id == 0) continue;
+        IngredienteBase *it = cat_buscar_id(cat, cat->por_nome[i].id);
+        if (it && strcmp(it->nome, nome) == 0) return it->id;
     }
     return -1;
 }
 
+/* 
+    cat_buscar_nome_ci
+        - Como cat_buscar_nome, mas "farinha" encontra "Farinha".
+ */
+int cat_buscar_nome_ci(const CatalogoIngredientes *cat, const char *nome) {
+    if (!cat || !nome) return -1;
+    size_t i = nome_lower_bound(cat, nome);
+    for (; i < cat->qtd_nomes && comparar_chave(cat->por_nome[i].chave, nome) == 0; ++i) {
+        if (cat->por_nome[i].id != 0) return cat->por_nome[i].id;
+    }
+    return -1;
+}
+
+/* 
+    cat_buscar_prefixo
+        - Todos os nomes com o mesmo prefixo ficam contíguos no índice
+          ordenado: basta uma busca binária e uma varredura curta.
+ */
+size_t cat_buscar_prefixo(const CatalogoIngredientes *cat, const char *prefixo, int *ids, size_t limite) {
+    if (!cat || !prefixo || !ids) return 0;
+    size_t n = 0;
+    size_t i = nome_lower_bound(cat, prefixo);
+    for (; n < limite && i < cat->qtd_nomes && chave_comeca_com(cat->por_nome[i].chave, prefixo); i++) {
+        if (cat->por_nome[i].id != 0) ids[n++] = cat->por_nome[i].id;
+    }
+    return n;
+}
+
 /* 
     Acessores simples: retornam const char* ou NULL se id não existir.
  */
@@ -123,15 +368,22 @@ int cat_editar(CatalogoIngredientes *cat, int id, const char *novo_nome, const c
     if (!it) return 0;
     
     if (novo_nome) {
-        char *n = utl_strdup(novo_nome);
-        if (!n) return 0;
-        free(it->nome);
+        char *n = copiar_texto(cat, novo_nome);
+        char *chave = copiar_chave(cat, novo_nome);
+        if (!n || !chave) {
+            soltar_texto(cat, n);
+            soltar_texto(cat, chave);
+            return 0;
+        }
+        desindexar_nome(cat, it->nome, id);
+        indexar_nome(cat, chave, id);
+        soltar_texto(cat, it->nome);
         it->nome = n;
     }
     if (nova_unidade) {
-        char *u = utl_strdup(nova_unidade);
+        char *u = copiar_texto(cat, nova_unidade);
         if (!u) return 0;
-        free(it->unidade);
+        soltar_texto(cat, it->unidade);
         it->unidade = u;
     }
     return 1;
@@ -139,29 +391,56 @@ int cat_editar(CatalogoIngredientes *cat, int id, const char *novo_nome, const c
 
 /* 
     cat_remover
-        - Remove item por id e compacta o array.
+        - Remove item por id deixando lapide no slot e no índice de nomes
+          (a busca da entrada é O(log n)): ninguém é deslocado, a geração
+          do slot sobe e ele vai para a pilha de livres.
  */
 int cat_remover(CatalogoIngredientes *cat, int id) {
     if (!cat) return 0;
-    int idx = -1;
-    for (size_t i = 0; i < cat->qtd_atual; ++i) {
-        if (cat->itens[i].id == id) {
-            idx = (int)i;
-            break;
-        }
-    }
+    int idx = hsh_buscar(&cat->por_id, id);
     if (idx == -1) return 0;
     
-    free(cat->itens[idx].nome);
-    free(cat->itens[idx].unidade);
+    desindexar_nome(cat, cat->itens[idx].nome, id);
+    soltar_texto(cat, cat->itens[idx].nome);
+    soltar_texto(cat, cat->itens[idx].unidade);
+    hsh_remover(&cat->por_id, id);
     
-    for (size_t j = idx; j + 1 < cat->qtd_atual; ++j) {
-        cat->itens[j] = cat->itens[j + 1];
-    }
+    cat->itens[idx].id = 0;
+    cat->itens[idx].nome = cat->itens[idx].unidade = NULL;
+    cat->itens[idx].geracao++;
+    cat->livres[cat->qtd_livres++] = (size_t)idx;
     cat->qtd_atual--;
     return 1;
 }
 
+/* 
+    cat_recopiar_textos
+        - Regrava em 'destino' os nomes, unidades e chaves dos itens vivos
+          (as lápides do índice de nomes saem antes). Textos de itens
+          removidos ou renomeados ficam para trás na arena antiga.
+        - Para no primeiro erro de memória: os textos já trocados apontam
+          para 'destino', o resto para a arena antiga, e ambos valem.
+ */
+int cat_recopiar_textos(CatalogoIngredientes *cat, ArenaStrings *destino) {
+    if (!cat || !cat->arena || !destino) return 0;
+    compactar_nomes(cat);
+    for (size_t i = 0; i < cat->qtd_slots; ++i) {
+        IngredienteBase *it = &cat->itens[i];
+        if (it->id == 0) continue;
+        char *n = arena_internar(destino, it->nome);
+        char *u = arena_internar(destino, it->unidade);
+        if (!n || !u) return 0;
+        it->nome = n;
+        it->unidade = u;
+    }
+    for (size_t i = 0; i < cat->qtd_nomes; ++i) {
+        char *chave = arena_internar(destino, cat->por_nome[i].chave);
+        if (!chave) return 0;
+        cat->por_nome[i].chave = chave;
+    }
+    return 1;
+}
+
 /* 
     cat_listar
         - Lista o catálogo no stdout em formato simples.
@@ -169,7 +448,8 @@ int cat_remover(CatalogoIngredientes *cat, int id) {
 void cat_listar(const CatalogoIngredientes *cat) {
     if (!cat) return;
     printf("--- CATALOGO DE INGREDIENTES (%zu itens) ---\n", cat->qtd_atual);
-    for (size_t i = 0; i < cat->qtd_atual; ++i) {
+    for (size_t i = 0; i < cat->qtd_slots; ++i) {
+        if (cat->itens[i].id == 0) continue;
         printf("[ID: %d] %s (%s)\n", cat->itens[i].id, cat->itens[i].nome, cat->itens[i].unidade);
     }
     printf("--------------------------------------------\n");
@@ -181,10 +461,14 @@ void cat_listar(const CatalogoIngredientes *cat) {
  */
 void cat_liberar(CatalogoIngredientes *cat) {
     if (!cat) return;
-    for (size_t i = 0; i < cat->qtd_atual; ++i) {
-        free(cat->itens[i].nome);
-        free(cat->itens[i].unidade);
+    for (size_t i = 0; i < cat->qtd_slots; ++i) {
+        soltar_texto(cat, cat->itens[i].nome);
+        soltar_texto(cat, cat->itens[i].unidade);
     }
+    for (size_t i = 0; i < cat->qtd_nomes; ++i) soltar_texto(cat, cat->por_nome[i].chave);
     free(cat->itens);
+    free(cat->por_nome);
+    free(cat->livres);
+    hsh_liberar(&cat->por_id);
     free(cat);
 }
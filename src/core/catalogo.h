@@ -2,29 +2,61 @@
 #define CATALOGO_H
 
 #include <stddef.h>
+#include "hash.h"
+#include "referencia.h"
+#include "arena.h"
+
+/* 
+ * Maior id aceito. Estoque e listas de espera da fila usam tabelas
+ * indexadas direto pelo id, entao um id absurdo vindo de arquivo, journal
+ * ou snapshot binario alocaria gigabytes; com o teto, o pior caso fica em
+ * algumas dezenas de MB. Ids acima disso sao recusados na carga.
+ */
+#define CAT_ID_MAXIMO (1 << 22)
 
 /* 
  * Tipo que representa um item do catalogo global.
  * IDs sao unicos e resolvidos pelo sistema para evitar divergencia de nomes.
  */
 typedef struct {
-    int id;         // id unico gerado por prox_id (>=1)
-    char *nome;     // string alocada dinamicamente
-    char *unidade;  // string alocada dinamicamente (ex: "g", "un", "ml")
+    int id;         // id unico gerado por prox_id (>=1); 0 = lapide (slot livre)
+    char *nome;     // string da arena do catalogo (so leitura) ou alocada sem arena
+    char *unidade;  // idem (ex: "g", "un", "ml"); unidades iguais dividem a mesma copia
+    unsigned geracao; // sobe a cada remocao do slot (ver Referencia)
 } IngredienteBase;
 
+/* 
+ * Entrada do indice de nomes: chave em minusculas + id do item.
+ * O array fica ordenado por (chave, id) para busca binaria. Remover um
+ * item so zera o id da entrada (lapide, a chave continua no lugar para a
+ * ordem valer); as lapides saem quando o indice e compactado.
+ */
+typedef struct {
+    char *chave;
+    int id;
+} EntradaNome;
+
 /* 
  * Estrutura que guarda todo o catalogo (array dinamico).
+ * A remocao deixa lapide (id 0) em vez de deslocar os seguintes; para
+ * percorrer, va ate qtd_slots pulando os itens com id 0.
  */
 typedef struct {
     IngredienteBase *itens;
-    size_t qtd_atual;
+    size_t qtd_atual;   // itens vivos
+    size_t qtd_slots;   // posicoes ja usadas em itens (vivas ou lapides)
     size_t capacidade;
+    size_t *livres;     // pilha de slots com lapide, reaproveitados primeiro
+    size_t qtd_livres;
     int prox_id;
+    IndiceHash por_id;  // id -> posicao em itens (busca O(1))
+    EntradaNome *por_nome;  // qtd_nomes entradas ordenadas (busca O(log n))
+    size_t qtd_nomes;       // entradas em por_nome, lapides incluidas
+    ArenaStrings *arena;    // de onde vem nome/unidade (NULL = utl_strdup)
 } CatalogoIngredientes;
 
-// Inicializa catalogo.
-int cat_inicializar(CatalogoIngredientes **cat);
+// Inicializa catalogo. arena pode ser NULL
+int cat_inicializar(CatalogoIngredientes **cat, ArenaStrings *arena);
 
 // Libera toda memoria associada ao catalogo
 void cat_liberar(CatalogoIngredientes *cat);
@@ -32,6 +64,9 @@ void cat_liberar(CatalogoIngredientes *cat);
 // Adiciona item (nome, unidade). Retorna id (>0) ou 0 se falha
 int cat_cadastrar(CatalogoIngredientes *cat, const char *nome, const char *unidade);
 
+// Adiciona item com id ja conhecido (carga de arquivo). Retorna id ou 0 se falha/duplicado/acima de CAT_ID_MAXIMO
+int cat_cadastrar_com_id(CatalogoIngredientes *cat, int id, const char *nome, const char *unidade);
+
 // Edita item: retorna 1 sucesso, 0 falha (id nao existe)
 int cat_editar(CatalogoIngredientes *cat, int id, const char *novo_nome, const char *nova_unidade);
 
@@ -41,13 +76,29 @@ int cat_remover(CatalogoIngredientes *cat, int id);
 // Retorna ponteiro para IngredienteBase pelo id, ou NULL se nao encontrar.
 IngredienteBase *cat_buscar_id(const CatalogoIngredientes *cat, int id);
 
+// Referencia estavel ao item (slot -1 se o id nao existe) e sua resolucao
+// (NULL se o item foi removido desde entao)
+Referencia cat_referencia(const CatalogoIngredientes *cat, int id);
+IngredienteBase *cat_resolver(const CatalogoIngredientes *cat, Referencia ref);
+
 // Busca id por nome (comparacao exata). Retorna id ou -1 se nao encontrado
 int cat_buscar_nome(const CatalogoIngredientes *cat, const char *nome);
 
+// Busca id por nome ignorando maiusculas/minusculas. Retorna id ou -1
+int cat_buscar_nome_ci(const CatalogoIngredientes *cat, const char *nome);
+
+// Preenche ate 'limite' ids cujo nome comeca com 'prefixo' (sem diferenciar
+// maiusculas), em ordem alfabetica. Retorna quantos ids foram escritos
+size_t cat_buscar_prefixo(const CatalogoIngredientes *cat, const char *prefixo, int *ids, size_t limite);
+
 // Acessores convenientes: retornam const char* (ou NULL se nao existir)
 const char *cat_get_nome(const CatalogoIngredientes *cat, int id);
 const char *cat_get_unidade(const CatalogoIngredientes *cat, int id);
 
+// Copia os textos dos itens vivos para 'destino' (compactacao da arena; so
+// com arena). Retorna 1 sucesso, 0 falha (ver app_compactar_textos)
+int cat_recopiar_textos(CatalogoIngredientes *cat, ArenaStrings *destino);
+
 // Lista o catalogo no stdout
 void cat_listar(const CatalogoIngredientes *cat);
 
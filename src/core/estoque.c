@@ -19,114 +19,314 @@ Estoque *est_inicializar() {
     if (!est) return NULL;
 
     est->itens = malloc(sizeof(ItemEstoque) * ESTOQUE_INITIAL_CAPACITY);
-    if (!est->itens) 
+    est->livres = malloc(sizeof(int) * ESTOQUE_INITIAL_CAPACITY);
+    if (!est->itens || !est->livres) 
     {
+        free(est->itens);
+        free(est->livres);
         free(est);
         return NULL;
     }
 
     est->qtd_atual = 0;
+    est->qtd_slots = 0;
+    est->qtd_livres = 0;
     est->capacidade = ESTOQUE_INITIAL_CAPACITY;
+    est->slot_por_id = NULL;
+    est->tam_slots = 0;
+    est->qtd_observadores = 0;
+    est->avisos_suspensos = 0;
     return est;
 }
 
 /*
     se o estoque não existir ignora
 
-    libera o espaço dos itens do estoque, depois libera o estoque
+    libera o espaço dos itens do estoque, a pilha de livres e a tabela de slots,
+    depois libera o estoque
 */
 void est_liberar(Estoque *est) {
     if (!est) return;
     free(est->itens);
+    free(est->livres);
+    free(est->slot_por_id);
     free(est);
 }
 
 /*
     se o estoque não existir retorna -1
 
-    usa um loop de for indo ate a quantidade atual de itens no estoque
-    compara o id_igrediente com o que ta procurando, se achar retorna o indice, se não -1
+    acesso direto: o id é o índice da tabela slot_por_id, que guarda
+    a posição do item em itens (ou -1). ids fora da tabela não estão no estoque
 */
-int est_buscar_indice(Estoque *est, int id_ingrediente) {
-    if (!est) return -1;
-    for (int i = 0; i < est->qtd_atual; ++i) {
-        if (est->itens[i].id_ingrediente == id_ingrediente) return i;
+int est_buscar_indice(const Estoque *est, int id_ingrediente) {
+    if (!est || id_ingrediente < 0 || id_ingrediente >= est->tam_slots) return -1;
+    return est->slot_por_id[id_ingrediente];
+}
+
+Referencia est_referencia(const Estoque *est, int id_ingrediente) {
+    Referencia ref = { -1, 0 };
+    int indice = est_buscar_indice(est, id_ingrediente);
+    if (indice != -1) {
+        ref.slot = indice;
+        ref.geracao = est->itens[indice].geracao;
     }
-    return -1;
+    return ref;
+}
+
+/*
+    a referencia so vale se o slot nao virou lapide nem foi reaproveitado
+    (a geracao sobe a cada remocao)
+*/
+ItemEstoque *est_resolver(Estoque *est, Referencia ref) {
+    if (!est || ref.slot < 0 || ref.slot >= est->qtd_slots) return NULL;
+    ItemEstoque *it = &est->itens[ref.slot];
+    return (it->id_ingrediente >= 0 && it->geracao == ref.geracao) ? it : NULL;
+}
+
+/* 
+    garantir_slot
+        - Aumenta a tabela slot_por_id até caber o id (dobrando o tamanho),
+          preenchendo as posições novas com -1.
+        - Retorna 1 em sucesso, 0 se o id é inválido (negativo ou acima de
+          CAT_ID_MAXIMO, o que limita o tamanho da tabela) ou o realloc falhou.
+ */
+static int garantir_slot(Estoque *est, int id_ingrediente) {
+    if (id_ingrediente < 0 || id_ingrediente > CAT_ID_MAXIMO) return 0;
+    if (id_ingrediente < est->tam_slots) return 1;
+    int novo_tam = est->tam_slots ? est->tam_slots : ESTOQUE_INITIAL_CAPACITY;
+    while (novo_tam <= id_ingrediente) novo_tam *= 2;
+    if (novo_tam > CAT_ID_MAXIMO + 1) novo_tam = CAT_ID_MAXIMO + 1;
+    int *nova = realloc(est->slot_por_id, sizeof(int) * (size_t)novo_tam);
+    if (!nova) return 0;
+    for (int i = est->tam_slots; i < novo_tam; i++) nova[i] = -1;
+    est->slot_por_id = nova;
+    est->tam_slots = novo_tam;
+    return 1;
+}
+
+/* Avisa os observadores (se houver) que a quantidade do ingrediente mudou */
+static void notificar(const Estoque *est, int id_ingrediente) {
+    if (est->avisos_suspensos) return;
+    for (int i = 0; i < est->qtd_observadores; i++)
+        est->observadores[i](est->ctx_observadores[i], id_ingrediente);
+}
+
+int est_observar(Estoque *est, EstObservador fn, void *ctx) {
+    if (!est || !fn || est->qtd_observadores >= EST_MAX_OBSERVADORES) return 0;
+    est->observadores[est->qtd_observadores] = fn;
+    est->ctx_observadores[est->qtd_observadores] = ctx;
+    est->qtd_observadores++;
+    return 1;
+}
+
+void est_suspender_avisos(Estoque *est) {
+    if (est) est->avisos_suspensos = 1;
+}
+
+/* Um aviso por item vivo cobre tudo o que mudou durante a suspensao */
+void est_retomar_avisos(Estoque *est) {
+    if (!est || !est->avisos_suspensos) return;
+    est->avisos_suspensos = 0;
+    for (int i = 0; i < est->qtd_slots; i++)
+        if (est->itens[i].id_ingrediente != -1) notificar(est, est->itens[i].id_ingrediente);
 }
 
 /* 
     ensure_capacity
-        - Verifica se há espaço no array para pelo menos mais 1 item.
-        - Se não houver, realoca o array dobrando a capacidade.
+        - Verifica se há espaço no array para pelo menos mais 'extra' slots novos.
+        - Se não houver, realoca o array (e a pilha de livres) dobrando a capacidade
+          até caber.
         - Retorna 1 em sucesso, 0 em falha (realloc falhou).
         
         Observação: função interna (static) para reduzir duplicação de código.
  */
-static int ensure_capacity(Estoque *est) {
-    if (est->qtd_atual < est->capacidade) return 1;
-    size_t newcap = est->capacidade * 2;
+static int ensure_capacity(Estoque *est, int extra) {
+    if (est->qtd_slots + extra <= est->capacidade) return 1;
+    size_t newcap = (size_t)est->capacidade * 2;
+    while (newcap < (size_t)est->qtd_slots + (size_t)extra) newcap *= 2;
     ItemEstoque *newitems = realloc(est->itens, sizeof(ItemEstoque) * newcap);
     if (!newitems) return 0;
     est->itens = newitems;
+    int *newlivres = realloc(est->livres, sizeof(int) * newcap);
+    if (!newlivres) return 0;
+    est->livres = newlivres;
     est->capacidade = (int)newcap;
     return 1;
 }
 
+/*
+    as quantidades ficam dentro de +-QTD_MAXIMO (quantidade.h): somar
+    entradas ou retiradas sem limite estouraria o int64, e a comparacao
+    de qtd_primeiro_insuficiente conta com essa faixa
+*/
+static Quantidade limitar(Quantidade q) {
+    if (q > QTD_MAXIMO) return QTD_MAXIMO;
+    if (q < -QTD_MAXIMO) return -QTD_MAXIMO;
+    return q;
+}
+
 /*
     primeiro procura o indice do item
     se encontrar o item, quando o indice não é -1, soma a qtd a quantidade total do item 
 
-    se não ajusta a capacidade se necessario, e coloca o item no proximo espaço e dps aumenta a quantidade atual
+    se não, reaproveita o ultimo slot que virou lapide; sem lapide, ajusta a capacidade
+    se necessario e usa o proximo espaço (geracao 0). Registra a posição na tabela
+    slot_por_id e aumenta a quantidade atual
 */
-void est_adicionar(Estoque *est, int id_ingrediente, float qtd) {
+void est_adicionar(Estoque *est, int id_ingrediente, Quantidade qtd) {
     if (!est) return;
     int indice = est_buscar_indice(est, id_ingrediente);
     if (indice != -1)
     {
-        est->itens[indice].quantidade += qtd;
+        /* as duas parcelas ja estao na faixa, entao a soma nao estoura antes do limite */
+        est->itens[indice].quantidade = limitar(est->itens[indice].quantidade + limitar(qtd));
+        notificar(est, id_ingrediente);
         return;
     }
-    if (ensure_capacity(est))
-    {
-        est->itens[est->qtd_atual].id_ingrediente = id_ingrediente;
-        est->itens[est->qtd_atual].quantidade = qtd;
-        est->qtd_atual += 1;
+    if (!garantir_slot(est, id_ingrediente)) return;
+    int slot;
+    if (est->qtd_livres > 0) {
+        slot = est->livres[--est->qtd_livres];
+    } else {
+        if (!ensure_capacity(est, 1)) return;
+        slot = est->qtd_slots++;
+        est->itens[slot].geracao = 0;
     }
+    est->slot_por_id[id_ingrediente] = slot;
+    est->itens[slot].id_ingrediente = id_ingrediente;
+    est->itens[slot].quantidade = limitar(qtd);
+    est->itens[slot].reservado = 0;
+    est->qtd_atual += 1;
+    notificar(est, id_ingrediente);
+}
+
+/*
+    est_adicionar_lote
+        - Conta os ids que ainda nao estao no estoque e cresce a tabela
+          slot_por_id e o array de itens uma vez so, para o lote inteiro;
+          depois soma item a item como o est_adicionar.
+        - Em ordem de id (como sai do agrupamento do chamador) os acessos a
+          slot_por_id andam para a frente na memoria.
+        - Retorna 0 (sem aplicar nada) se faltou memoria ou ha id negativo.
+ */
+int est_adicionar_lote(Estoque *est, const EntradaEstoque *entradas, int n) {
+    if (!est || (n > 0 && !entradas)) return 0;
+    int maior = -1, novos = 0;
+    for (int i = 0; i < n; i++) {
+        if (entradas[i].id_ingrediente < 0) return 0;
+        if (entradas[i].id_ingrediente > maior) maior = entradas[i].id_ingrediente;
+        if (est_buscar_indice(est, entradas[i].id_ingrediente) == -1) novos++;
+    }
+    if (maior >= 0 && !garantir_slot(est, maior)) return 0;
+    if (novos > est->qtd_livres && !ensure_capacity(est, novos - est->qtd_livres)) return 0;
+    for (int i = 0; i < n; i++)
+        est_adicionar(est, entradas[i].id_ingrediente, entradas[i].qtd);
+    return 1;
 }
 
 /*
     procura o indice do item
     se não encontrar ou a quantida a ser removida for negativa, retorna 0
 
-    ve se a quantidade de items é maior ou igual do que vai ser removido
-    se for subtrai e retorna 1
-
-    se não retorna 0
+    ve se a quantidade disponivel (sem a parte reservada) é maior ou igual
+    do que vai ser removido; se for retorna 1, se não retorna 0
+    (só consulta: é a mesma conta que o est_remover faz antes de subtrair)
 */
-int est_remover(Estoque *est, int id_ingrediente, float qtd) {
+int est_pode_remover(const Estoque *est, int id_ingrediente, Quantidade qtd) {
     if (!est) return 0;
     int indice = est_buscar_indice(est, id_ingrediente);
     if (indice == -1 || qtd <= 0) return 0;
+    return est->itens[indice].quantidade - est->itens[indice].reservado >= qtd;
+}
+
+int est_remover(Estoque *est, int id_ingrediente, Quantidade qtd) {
+    if (!est_pode_remover(est, id_ingrediente, qtd)) return 0;
+    int indice = est_buscar_indice(est, id_ingrediente);
+    est->itens[indice].quantidade -= qtd;
+    notificar(est, id_ingrediente);
+    return 1;
+}
 
-    if (est->itens[indice].quantidade >= qtd)
+/*
+    igual ao est_adicionar, mas substitui a quantidade em vez de somar
+    (usado ao reaplicar o journal, onde o registro guarda o valor final)
+*/
+void est_definir(Estoque *est, int id_ingrediente, Quantidade qtd) {
+    if (!est) return;
+    int indice = est_buscar_indice(est, id_ingrediente);
+    if (indice != -1)
     {
-        est->itens[indice].quantidade -= qtd;
-        return 1;
+        est->itens[indice].quantidade = limitar(qtd);
+        notificar(est, id_ingrediente);
+        return;
     }
-    
-    return 0;
+    est_adicionar(est, id_ingrediente, qtd);
+}
+
+/* Quantidade que ainda pode ser usada ou reservada (0 se o item nao existe) */
+Quantidade est_disponivel(const Estoque *est, int id_ingrediente) {
+    int indice = est_buscar_indice(est, id_ingrediente);
+    if (indice == -1) return 0;
+    return est->itens[indice].quantidade - est->itens[indice].reservado;
 }
 
-/* Remove completamente um item do estoque (compacta o array) */
+/*
+    separa qtd do disponivel para um pedido; a quantidade em si nao muda
+    (so deixa de estar disponivel). Retorna 0 se nao ha o suficiente
+*/
+int est_reservar(Estoque *est, int id_ingrediente, Quantidade qtd) {
+    if (!est || qtd < 0) return 0;
+    int indice = est_buscar_indice(est, id_ingrediente);
+    if (indice == -1) return 0;
+    if (est->itens[indice].quantidade - est->itens[indice].reservado < qtd) return 0;
+    est->itens[indice].reservado += qtd;
+    notificar(est, id_ingrediente);
+    return 1;
+}
+
+/*
+    devolve ao disponivel uma reserva (pedido cancelado). Devolver mais do
+    que esta reservado e erro de contabilidade de quem chamou: retorna 0
+    sem mexer em nada, em vez de zerar o reservado e esconder o problema
+*/
+int est_liberar_reserva(Estoque *est, int id_ingrediente, Quantidade qtd) {
+    if (!est || qtd < 0) return 0;
+    int indice = est_buscar_indice(est, id_ingrediente);
+    if (indice == -1 || qtd > est->itens[indice].reservado) return 0;
+    est->itens[indice].reservado -= qtd;
+    notificar(est, id_ingrediente);
+    return 1;
+}
+
+/*
+    o pedido reservado foi feito: a reserva vira retirada, sem nova
+    verificacao do disponivel. Mesma regra do est_liberar_reserva, e a
+    quantidade nunca fica negativa
+*/
+int est_consumir_reserva(Estoque *est, int id_ingrediente, Quantidade qtd) {
+    if (!est || qtd < 0) return 0;
+    int indice = est_buscar_indice(est, id_ingrediente);
+    if (indice == -1) return 0;
+    ItemEstoque *it = &est->itens[indice];
+    if (qtd > it->reservado || qtd > it->quantidade) return 0;
+    it->quantidade -= qtd;
+    it->reservado -= qtd;
+    notificar(est, id_ingrediente);
+    return 1;
+}
+
+/* Remove completamente um item do estoque: o slot vira lapide (nada e deslocado) e vai para os livres */
 int est_deletar_item(Estoque *est, int id_ingrediente) {
     if (!est) return 0;
     int indice = est_buscar_indice(est, id_ingrediente);
     if (indice == -1) return 0;
-    for (int j = indice; j < est->qtd_atual - 1; j++) {
-        est->itens[j] = est->itens[j + 1];
-    }
+    est->slot_por_id[id_ingrediente] = -1;
+    est->itens[indice].id_ingrediente = -1;
+    est->itens[indice].geracao++;
+    est->livres[est->qtd_livres++] = indice;
     est->qtd_atual--;
+    notificar(est, id_ingrediente);
     return 1;
 }
 
@@ -140,9 +340,10 @@ void est_listar(const Estoque *est, const CatalogoIngredientes *cat) {
     
     printf("\n--- ESTOQUE ATUAL (%d tipos de itens) ---\n", est->qtd_atual);
     
-    for (int i = 0; i < est->qtd_atual; ++i) {
+    for (int i = 0; i < est->qtd_slots; ++i) {
         int id = est->itens[i].id_ingrediente;
-        float qtd = est->itens[i].quantidade;
+        if (id < 0) continue;
+        Quantidade qtd = est->itens[i].quantidade;
         
         const char *nome = cat_get_nome(cat, id);
         const char *unidade = cat_get_unidade(cat, id);
@@ -150,7 +351,8 @@ void est_listar(const Estoque *est, const CatalogoIngredientes *cat) {
         const char *nome_exibicao = nome ? nome : "Desconhecido";
         const char *unid_exibicao = unidade ? unidade : "";
 
-        printf("  [ID: %d] %s: %.2f %s\n", id, nome_exibicao, qtd, unid_exibicao);
+        char txt[QTD_TEXTO_MAX];
+        printf("  [ID: %d] %s: %s %s\n", id, nome_exibicao, qtd_formatar(qtd, txt, sizeof(txt)), unid_exibicao);
     }
     printf("------------------------------------------\n");
 }
@@ -2,26 +2,81 @@
 #define ESTOQUE_H
 
 #include "catalogo.h"
+#include "referencia.h"
+#include "quantidade.h"
 
 typedef struct {
-    int id_ingrediente;
-    float quantidade;
+    int id_ingrediente; // -1 = lapide (slot livre)
+    Quantidade quantidade; // em milesimos da unidade (ver quantidade.h)
+    Quantidade reservado;  // parte da quantidade presa a pedidos na fila (modo reserva)
+    unsigned geracao;  // sobe a cada remocao do slot (ver Referencia)
 } ItemEstoque;
 
+/* Uma linha de entrega: qtd a somar no ingrediente (ver est_adicionar_lote) */
+typedef struct {
+    int id_ingrediente;
+    Quantidade qtd;
+} EntradaEstoque;
+
+/* Chamado depois de toda mudanca de quantidade de um ingrediente */
+typedef void (*EstObservador)(void *ctx, int id_ingrediente);
+
+#define EST_MAX_OBSERVADORES 4
+
+/* 
+ * Os ids do catalogo sao densos (gerados por prox_id), entao a posicao
+ * de cada ingrediente em 'itens' fica numa tabela indexada direto pelo id:
+ * slot_por_id[id] = posicao, ou -1 se o ingrediente nao esta no estoque.
+ *
+ * est_deletar_item deixa lapide (id_ingrediente -1) em vez de compactar;
+ * para percorrer, va ate qtd_slots pulando as lapides.
+ */
 typedef struct {
     ItemEstoque *itens;
-    int qtd_atual;
+    int qtd_atual;   // itens vivos
+    int qtd_slots;   // posicoes ja usadas em itens (vivas ou lapides)
     int capacidade;
+    int *livres;     // pilha de slots com lapide, reaproveitados primeiro
+    int qtd_livres;
+    int *slot_por_id;
+    int tam_slots;   // ids validos na tabela: 0 .. tam_slots-1
+    EstObservador observadores[EST_MAX_OBSERVADORES]; // ex: cache de porcoes, fila de espera
+    void *ctx_observadores[EST_MAX_OBSERVADORES];
+    int qtd_observadores;
+    int avisos_suspensos; // ver est_suspender_avisos
 } Estoque;
 
 Estoque *est_inicializar();
 void est_liberar(Estoque *est);
 
-int est_buscar_indice(Estoque *est, int id_ingrediente);
+int est_buscar_indice(const Estoque *est, int id_ingrediente);
+Referencia est_referencia(const Estoque *est, int id_ingrediente); /* slot -1 se nao esta no estoque */
+ItemEstoque *est_resolver(Estoque *est, Referencia ref);          /* NULL se o item saiu desde entao */
 void est_listar(const Estoque *est, const CatalogoIngredientes *cat);
 
-void est_adicionar(Estoque *est, int id_ingrediente, float qtd);
-int est_remover(Estoque *est, int id_ingrediente, float qtd);
+void est_adicionar(Estoque *est, int id_ingrediente, Quantidade qtd);
+int est_remover(Estoque *est, int id_ingrediente, Quantidade qtd);
+int est_pode_remover(const Estoque *est, int id_ingrediente, Quantidade qtd); /* 1 se est_remover daria certo (nao altera nada) */
+void est_definir(Estoque *est, int id_ingrediente, Quantidade qtd); /* Grava a quantidade absoluta (cria o item se preciso) */
+int est_adicionar_lote(Estoque *est, const EntradaEstoque *entradas, int n); /* est_adicionar de cada entrada, crescendo uma vez so. 0 se faltou memoria */
 int est_deletar_item(Estoque *est, int id_ingrediente); /* Remove o item completamente do estoque */
 
+/* Reservas: a quantidade disponivel e quantidade - reservado.
+   est_remover tambem so retira do que esta disponivel */
+Quantidade est_disponivel(const Estoque *est, int id_ingrediente);
+int est_reservar(Estoque *est, int id_ingrediente, Quantidade qtd);          /* 0 se nao ha disponivel suficiente */
+int est_liberar_reserva(Estoque *est, int id_ingrediente, Quantidade qtd);   /* 0 (nada muda) se qtd passa do reservado */
+int est_consumir_reserva(Estoque *est, int id_ingrediente, Quantidade qtd);  /* baixa o que ja estava reservado; 0 como acima */
+
+int est_observar(Estoque *est, EstObservador fn, void *ctx); /* Registra mais alguem para avisar a cada mudanca. 0 se lotado */
+
+/* 
+ * Os observadores leem outras estruturas (o cache de producao le o indice
+ * invertido do banco de receitas). Enquanto elas sao montadas em outra
+ * thread, os avisos ficam suspensos; est_retomar_avisos avisa uma vez
+ * cada ingrediente do estoque, ja sem concorrencia.
+ */
+void est_suspender_avisos(Estoque *est);
+void est_retomar_avisos(Estoque *est);
+
 #endif
@@ -0,0 +1,129 @@
+#include "hash.h"
+#include <stdlib.h>
+
+#define HSH_CAPACIDADE_MINIMA 16
+
+/*
+    hsh_posicao
+        - Espalha a chave com o multiplicador de Fibonacci (Knuth) e
+          reduz para o intervalo [0, capacidade) com mascara.
+ */
+static size_t hsh_posicao(const IndiceHash *h, int chave) {
+    unsigned int x = (unsigned int)chave * 2654435769u;
+    return (size_t)(x ^ (x >> 16)) & (h->capacidade - 1);
+}
+
+static int alocar(IndiceHash *h, size_t capacidade) {
+    h->chaves = malloc(sizeof(int) * capacidade);
+    h->valores = malloc(sizeof(int) * capacidade);
+    if (!h->chaves || !h->valores) {
+        free(h->chaves);
+        free(h->valores);
+        h->chaves = h->valores = NULL;
+        return 0;
+    }
+    for (size_t i = 0; i < capacidade; i++) h->valores[i] = -1;
+    h->capacidade = capacidade;
+    h->qtd = 0;
+    return 1;
+}
+
+int hsh_inicializar(IndiceHash *h, size_t capacidade_inicial) {
+    if (!h) return 0;
+    size_t cap = HSH_CAPACIDADE_MINIMA;
+    while (cap < capacidade_inicial) cap *= 2;
+    return alocar(h, cap);
+}
+
+void hsh_liberar(IndiceHash *h) {
+    if (!h) return;
+    free(h->chaves);
+    free(h->valores);
+    h->chaves = h->valores = NULL;
+    h->capacidade = h->qtd = 0;
+}
+
+void hsh_limpar(IndiceHash *h) {
+    if (!h || !h->valores) return;
+    for (size_t i = 0; i < h->capacidade; i++) h->valores[i] = -1;
+    h->qtd = 0;
+}
+
+/*
+    redimensionar
+        - Realoca com o dobro da capacidade e reinsere todas as chaves.
+ */
+static int redimensionar(IndiceHash *h) {
+    IndiceHash novo;
+    if (!alocar(&novo, h->capacidade * 2)) return 0;
+    for (size_t i = 0; i < h->capacidade; i++) {
+        if (h->valores[i] < 0) continue;
+        size_t p = hsh_posicao(&novo, h->chaves[i]);
+        while (novo.valores[p] >= 0) p = (p + 1) & (novo.capacidade - 1);
+        novo.chaves[p] = h->chaves[i];
+        novo.valores[p] = h->valores[i];
+        novo.qtd++;
+    }
+    hsh_liberar(h);
+    *h = novo;
+    return 1;
+}
+
+int hsh_inserir(IndiceHash *h, int chave, int valor) {
+    if (!h || !h->valores || valor < 0) return 0;
+    if ((h->qtd + 1) * 10 > h->capacidade * 7) {
+        if (!redimensionar(h)) return 0;
+    }
+    size_t p = hsh_posicao(h, chave);
+    while (h->valores[p] >= 0) {
+        if (h->chaves[p] == chave) {
+            h->valores[p] = valor;
+            return 1;
+        }
+        p = (p + 1) & (h->capacidade - 1);
+    }
+    h->chaves[p] = chave;
+    h->valores[p] = valor;
+    h->qtd++;
+    return 1;
+}
+
+int hsh_buscar(const IndiceHash *h, int chave) {
+    if (!h || !h->valores) return -1;
+    size_t p = hsh_posicao(h, chave);
+    while (h->valores[p] >= 0) {
+        if (h->chaves[p] == chave) return h->valores[p];
+        p = (p + 1) & (h->capacidade - 1);
+    }
+    return -1;
+}
+
+/*
+    hsh_remover
+        - Apos esvaziar a posicao, puxa para tras os elementos seguintes
+          do mesmo "cluster" que ficariam inalcancaveis (backward shift).
+ */
+int hsh_remover(IndiceHash *h, int chave) {
+    if (!h || !h->valores) return 0;
+    size_t mask = h->capacidade - 1;
+    size_t p = hsh_posicao(h, chave);
+    while (h->valores[p] >= 0 && h->chaves[p] != chave) p = (p + 1) & mask;
+    if (h->valores[p] < 0) return 0;
+
+    size_t vazio = p;
+    size_t j = p;
+    for (;;) {
+        j = (j + 1) & mask;
+        if (h->valores[j] < 0) break;
+        size_t ideal = hsh_posicao(h, h->chaves[j]);
+        // Move se a posicao ideal de j nao esta no intervalo circular (vazio, j]
+        if (((j - ideal) & mask) >= ((j - vazio) & mask)) {
+            h->chaves[vazio] = h->chaves[j];
+            h->valores[vazio] = h->valores[j];
+            vazio = j;
+        }
+    }
+    h->valores[vazio] = -1;
+    h->qtd--;
+    return 1;
+}
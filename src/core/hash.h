@@ -0,0 +1,39 @@
+#ifndef HASH_H
+#define HASH_H
+
+#include <stddef.h>
+
+/*
+ * Tabela hash de enderecamento aberto (sondagem linear) que mapeia
+ * uma chave inteira (ex: id de ingrediente) para um valor inteiro >= 0
+ * (ex: posicao do item no array dinamico do modulo dono).
+ *
+ * A capacidade e sempre potencia de 2 e a tabela cresce ao passar de
+ * 70% de ocupacao. Remocao usa "backward shift", sem lapides.
+ */
+typedef struct {
+    int *chaves;
+    int *valores;      // -1 marca posicao livre
+    size_t capacidade;
+    size_t qtd;
+} IndiceHash;
+
+// Inicializa a tabela. Retorna 1 sucesso, 0 falha de alocacao
+int hsh_inicializar(IndiceHash *h, size_t capacidade_inicial);
+
+// Libera os arrays internos (a struct em si pertence ao chamador)
+void hsh_liberar(IndiceHash *h);
+
+// Remove todas as chaves mantendo a capacidade
+void hsh_limpar(IndiceHash *h);
+
+// Insere ou atualiza chave -> valor (valor >= 0). Retorna 1 sucesso, 0 falha
+int hsh_inserir(IndiceHash *h, int chave, int valor);
+
+// Retorna o valor associado a chave, ou -1 se nao existir
+int hsh_buscar(const IndiceHash *h, int chave);
+
+// Remove a chave. Retorna 1 se removeu, 0 se nao existia
+int hsh_remover(IndiceHash *h, int chave);
+
+#endif
@@ -1,119 +1,134 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include "ingredientes.h"
 
-/* Implementação de ing_criar_no */
-NoIngrediente* ing_criar_no(int id_ingrediente, float qtd) {
-    NoIngrediente* novo = (NoIngrediente*) malloc(sizeof(NoIngrediente));
-    if (novo != NULL) {
-        novo->id_ingrediente = id_ingrediente;
-        novo->quantidade = qtd;
-        novo->prox = NULL;
+#define ING_CAPACIDADE_INICIAL 4
+
+void ing_inicializar(VetorIngredientes* v) {
+    if (!v) return;
+    v->itens = NULL;
+    v->qtd = 0;
+    v->capacidade = 0;
+}
+
+/* Acima desse tamanho a busca binaria ganha da contagem (make bench) */
+#define ING_LIMITE_CONTAGEM 32
+
+/* 
+    posicao
+        - Posicao do id no vetor, ou a posicao onde ele entraria.
+        - Ate ING_LIMITE_CONTAGEM itens: como o vetor esta ordenado, a posicao
+          e quantos ids sao menores. A contagem nao tem desvio que dependa
+          dos dados, entao nao erra previsao como a binaria.
+        - Acima disso, busca binaria.
+ */
+static int posicao(const VetorIngredientes* v, int id_ingrediente) {
+    int ini = 0, fim = v->qtd;
+    if (fim <= ING_LIMITE_CONTAGEM) {
+        for (int k = 0; k < fim; k++) ini += v->itens[k].id_ingrediente < id_ingrediente;
+        return ini;
     }
-    return novo;
+    while (ini < fim) {
+        int meio = ini + (fim - ini) / 2;
+        if (v->itens[meio].id_ingrediente < id_ingrediente) ini = meio + 1;
+        else fim = meio;
+    }
+    return ini;
 }
 
-/* Implementação de ing_adicionar */
-void ing_adicionar(NoIngrediente** cabeca, int id_ingrediente, float qtd) {
-    if (!cabeca) return;
+/* Garante espaco para mais um item, dobrando a capacidade */
+static int garantir_capacidade(VetorIngredientes* v) {
+    if (v->qtd < v->capacidade) return 1;
+    int nova = v->capacidade ? v->capacidade * 2 : ING_CAPACIDADE_INICIAL;
+    IngredienteReceita* novo = realloc(v->itens, sizeof(IngredienteReceita) * nova);
+    if (!novo) return 0;
+    v->itens = novo;
+    v->capacidade = nova;
+    return 1;
+}
 
-    // 1. Verifica se o ingrediente já existe na lista (atualização)
-    NoIngrediente* busca = ing_buscar(*cabeca, id_ingrediente);
-    
-    if (busca != NULL) {
-        // Se já existe, apenas atualizamos a quantidade
-        busca->quantidade = qtd;
-        return;
+/* Implementação de ing_adicionar */
+int ing_adicionar(VetorIngredientes* v, int id_ingrediente, Quantidade qtd) {
+    if (!v) return 0;
+
+    // 1. Busca (posicao): se o ingrediente ja existe, apenas atualiza a quantidade
+    int pos = posicao(v, id_ingrediente);
+    if (pos < v->qtd && v->itens[pos].id_ingrediente == id_ingrediente) {
+        v->itens[pos].quantidade = qtd;
+        return 1;
     }
 
-    // 2. Se não existe, cria um novo nó
-    NoIngrediente* novo = ing_criar_no(id_ingrediente, qtd);
-    if (novo == NULL) {
+    // 2. Se não existe, abre espaco na posicao ordenada
+    if (!garantir_capacidade(v)) {
         fprintf(stderr, "Erro: Falha ao alocar memoria para ingrediente.\n");
-        return;
+        return 0;
     }
+    memmove(&v->itens[pos + 1], &v->itens[pos], sizeof(IngredienteReceita) * (size_t)(v->qtd - pos));
 
-    // 3. Insere no início da lista (complexidade O(1))
-    novo->prox = *cabeca;
-    *cabeca = novo;
+    // 3. Ids em ordem crescente (carga de arquivo) caem no fim: sem deslocamento
+    v->itens[pos].id_ingrediente = id_ingrediente;
+    v->itens[pos].quantidade = qtd;
+    v->qtd++;
+    return 1;
 }
 
 /* Implementação de ing_remover */
-int ing_remover(NoIngrediente** cabeca, int id_ingrediente) {
-    if (!cabeca || *cabeca == NULL) return 0; // Lista vazia
+int ing_remover(VetorIngredientes* v, int id_ingrediente) {
+    if (!v || v->qtd == 0) return 0; // Vetor vazio
 
-    NoIngrediente* atual = *cabeca;
-    NoIngrediente* anterior = NULL;
+    int pos = posicao(v, id_ingrediente);
+    if (pos == v->qtd || v->itens[pos].id_ingrediente != id_ingrediente) return 0; // Não encontrou
 
-    while (atual != NULL && atual->id_ingrediente != id_ingrediente) {
-        anterior = atual;
-        atual = atual->prox;
-    }
-
-    if (atual == NULL) return 0; // Não encontrou
-
-    // Se for o primeiro da lista
-    if (anterior == NULL) {
-        *cabeca = atual->prox;
-    } else {
-        anterior->prox = atual->prox;
-    }
-
-    free(atual);
+    // Fecha o buraco deslocando os seguintes
+    memmove(&v->itens[pos], &v->itens[pos + 1], sizeof(IngredienteReceita) * (size_t)(v->qtd - pos - 1));
+    v->qtd--;
     return 1; // Sucesso
 }
 
 /* Implementação de ing_buscar */
-NoIngrediente* ing_buscar(NoIngrediente* cabeca, int id_ingrediente) {
-    NoIngrediente* atual = cabeca;
-    while (atual != NULL) {
-        if (atual->id_ingrediente == id_ingrediente) {
-            return atual;
-        }
-        atual = atual->prox;
-    }
+IngredienteReceita* ing_buscar(const VetorIngredientes* v, int id_ingrediente) {
+    if (!v) return NULL;
+    int pos = posicao(v, id_ingrediente);
+    if (pos < v->qtd && v->itens[pos].id_ingrediente == id_ingrediente)
+        return &v->itens[pos];
     return NULL;
 }
 
 /* Implementação de ing_listar */
-void ing_listar(NoIngrediente* cabeca, const CatalogoIngredientes* cat) {
-    if (cabeca == NULL) {
+void ing_listar(const VetorIngredientes* v, const CatalogoIngredientes* cat) {
+    if (!v || v->qtd == 0) {
         printf("   (Nenhum ingrediente cadastrado nesta receita)\n");
         return;
     }
 
-    NoIngrediente* atual = cabeca;
     printf("   Ingredientes:\n");
     
-    while (atual != NULL) {
+    for (int k = 0; k < v->qtd; k++) {
+        const IngredienteReceita* atual = &v->itens[k];
+        char txt[QTD_TEXTO_MAX];
+        qtd_formatar(atual->quantidade, txt, sizeof(txt));
         // Busca os detalhes do ingrediente no Catálogo
         IngredienteBase* info = cat_buscar_id(cat, atual->id_ingrediente);
 
         if (info != NULL) {
-            printf("   - [ID: %d] %s: %.2f %s\n", 
+            printf("   - [ID: %d] %s: %s %s\n", 
                    atual->id_ingrediente, 
                    info->nome, 
-                   atual->quantidade, 
+                   txt, 
                    info->unidade);
         } else {
             // Caso de borda: ID existe na receita mas foi apagado do catálogo
-            printf("   - [ID: %d] (Ingrediente desconhecido): %.2f\n", 
+            printf("   - [ID: %d] (Ingrediente desconhecido): %s\n", 
                    atual->id_ingrediente, 
-                   atual->quantidade);
+                   txt);
         }
-
-        atual = atual->prox;
     }
 }
 
-/* Implementação de ing_liberar_lista */
-void ing_liberar_lista(NoIngrediente** cabeca) {
-    if (!cabeca) return;
-    NoIngrediente* atual = *cabeca;
-    while (atual != NULL) {
-        NoIngrediente* temp = atual;
-        atual = atual->prox;
-        free(temp);
-    }
-    *cabeca = NULL; // É boa prática zerar o ponteiro da cabeça
+/* Implementação de ing_liberar */
+void ing_liberar(VetorIngredientes* v) {
+    if (!v) return;
+    free(v->itens);
+    ing_inicializar(v);
 }
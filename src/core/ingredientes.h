@@ -6,46 +6,59 @@
  * para a funcao de listagem (para mostrar nomes em vez de apenas IDs).
  */
 #include "catalogo.h"
+#include "quantidade.h"
 
 /* 
- * Estrutura do No da Lista Encadeada
+ * Ingrediente de uma receita.
  * Armazena apenas o ID e a quantidade. O nome vem do catalogo.
  */
-typedef struct NoIngrediente {
+typedef struct {
     int id_ingrediente;
-    float quantidade;           // Quantidade necessaria para a receita
-    struct NoIngrediente* prox; // Ponteiro para o proximo ingrediente
-} NoIngrediente;
+    Quantidade quantidade;      // Necessaria para a receita, em milesimos
+} IngredienteReceita;
 
-/* Cria um novo no isolado (funcao auxiliar) */
-NoIngrediente* ing_criar_no(int id_ingrediente, float qtd);
+/* 
+ * Vetor dinamico de ingredientes, sempre ordenado por id_ingrediente.
+ * Fica num bloco contiguo: percorrer e sequencial na memoria. A busca por
+ * id conta os menores ate 32 itens e e binaria acima. Percorrer: for (k = 0; k < v->qtd; k++) v->itens[k]
+ */
+typedef struct {
+    IngredienteReceita* itens;
+    int qtd;
+    int capacidade;
+} VetorIngredientes;
+
+/* Vetor vazio (nao aloca nada ate o primeiro ingrediente) */
+void ing_inicializar(VetorIngredientes* v);
 
 /* 
- * Adiciona um ingrediente a lista.
+ * Adiciona um ingrediente ao vetor.
  * Se o ID ja existir, ATUALIZA a quantidade.
- * Se nao existir, insere no inicio (mais eficiente).
+ * Se nao existir, insere na posicao que mantem a ordem por id.
+ * Retorna 1 sucesso, 0 falha de alocacao.
  */
-void ing_adicionar(NoIngrediente** cabeca, int id_ingrediente, float qtd);
+int ing_adicionar(VetorIngredientes* v, int id_ingrediente, Quantidade qtd);
 
 /* 
- * Remove um ingrediente da lista pelo ID.
+ * Remove um ingrediente pelo ID.
  * Retorna 1 se sucesso, 0 se nao encontrou.
  */
-int ing_remover(NoIngrediente** cabeca, int id_ingrediente);
+int ing_remover(VetorIngredientes* v, int id_ingrediente);
 
 /* 
- * Busca um no especifico pelo ID.
- * Retorna o ponteiro ou NULL se nao achar.
+ * Busca um ingrediente pelo ID (contagem ate 32 itens, binaria acima).
+ * Retorna o ponteiro ou NULL se nao achar. O ponteiro vale ate a
+ * proxima insercao/remocao no vetor.
  */
-NoIngrediente* ing_buscar(NoIngrediente* cabeca, int id_ingrediente);
+IngredienteReceita* ing_buscar(const VetorIngredientes* v, int id_ingrediente);
 
 /* 
  * Lista os ingredientes da receita.
  * Usa o ponteiro 'cat' para buscar o nome e a unidade de cada ID.
  */
-void ing_listar(NoIngrediente* cabeca, const CatalogoIngredientes* cat);
+void ing_listar(const VetorIngredientes* v, const CatalogoIngredientes* cat);
 
-/* Libera toda a memoria da lista encadeada */
-void ing_liberar_lista(NoIngrediente** cabeca);
+/* Libera a memoria do vetor (fica vazio, pronto para reuso) */
+void ing_liberar(VetorIngredientes* v);
 
 #endif
@@ -0,0 +1,111 @@
+#include "leitor.h"
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+int lei_abrir(LeitorLinhas* l, const char* path) {
+    if (!l) return 0;
+    l->buf = NULL;
+    l->f = fopen(path, "rb");
+    if (!l->f) return 0;
+    l->cap = LEITOR_TAM_BLOCO;
+    l->buf = malloc(l->cap);
+    if (!l->buf) {
+        fclose(l->f);
+        l->f = NULL;
+        return 0;
+    }
+    l->ini = l->fim = 0;
+    l->eof = 0;
+    l->sem_quebra = 0;
+    return 1;
+}
+
+void lei_fechar(LeitorLinhas* l) {
+    if (!l) return;
+    if (l->f) fclose(l->f);
+    free(l->buf);
+    l->f = NULL;
+    l->buf = NULL;
+}
+
+/*
+    lei_proxima
+        - Procura o '\n' no que ja esta no buffer (memchr). Sem ele, a linha
+          incompleta vai para o inicio do buffer e o proximo bloco e lido
+          logo atras; se a linha sozinha ja ocupa o buffer, ele dobra.
+        - Sempre sobra 1 byte alem de 'fim' para o '\0' da ultima linha
+          (arquivo sem '\n' no final).
+        - Faltando memoria para uma linha gigante, a leitura para ali.
+ */
+char* lei_proxima(LeitorLinhas* l, size_t* len) {
+    if (!l || !l->buf) return NULL;
+    for (;;) {
+        char* ini = l->buf + l->ini;
+        char* nl = memchr(ini, '\n', l->fim - l->ini);
+        if (nl || (l->eof && l->fim > l->ini)) {
+            char* fim_linha = nl ? nl : l->buf + l->fim;
+            l->ini = nl ? (size_t)(nl - l->buf) + 1 : l->fim;
+            l->sem_quebra = !nl;
+            if (fim_linha > ini && fim_linha[-1] == '\r') fim_linha--;
+            *fim_linha = '\0';
+            if (len) *len = (size_t)(fim_linha - ini);
+            return ini;
+        }
+        if (l->eof) return NULL;
+
+        if (l->ini > 0) {
+            memmove(l->buf, ini, l->fim - l->ini);
+            l->fim -= l->ini;
+            l->ini = 0;
+        }
+        if (l->fim + 1 >= l->cap) {
+            char* maior = realloc(l->buf, l->cap * 2);
+            if (!maior) return NULL;
+            l->buf = maior;
+            l->cap *= 2;
+        }
+        size_t n = fread(l->buf + l->fim, 1, l->cap - 1 - l->fim, l->f);
+        if (n == 0) l->eof = 1;
+        l->fim += n;
+    }
+}
+
+char* lei_campo(char** cursor) {
+    char* ini = cursor ? *cursor : NULL;
+    if (!ini) return NULL;
+    char* sep = strchr(ini, ';');
+    if (sep) {
+        *sep = '\0';
+        *cursor = sep + 1;
+    } else {
+        *cursor = NULL;
+    }
+    return ini;
+}
+
+char* lei_resto(char** cursor) {
+    char* ini = cursor ? *cursor : NULL;
+    if (cursor) *cursor = NULL;
+    return ini;
+}
+
+/* Espacos em volta sao aceitos; qualquer outro caractere invalida */
+int lei_int(const char* s, int* out) {
+    if (!s || !out) return 0;
+    while (*s == ' ' || *s == '\t') s++;
+    int negativo = 0;
+    if (*s == '-' || *s == '+') negativo = (*s++ == '-');
+    if (*s < '0' || *s > '9') return 0;
+    long long v = 0;
+    for (; *s >= '0' && *s <= '9'; s++) {
+        v = v * 10 + (*s - '0');
+        if (v > (long long)INT_MAX + 1) return 0;
+    }
+    while (*s == ' ' || *s == '\t') s++;
+    if (*s) return 0;
+    if (negativo) v = -v;
+    if (v > INT_MAX || v < INT_MIN) return 0;
+    *out = (int)v;
+    return 1;
+}
@@ -0,0 +1,45 @@
+#ifndef LEITOR_H
+#define LEITOR_H
+
+#include <stdio.h>
+#include <stddef.h>
+
+/*
+ * Leitura de arquivos de texto em blocos grandes (LEITOR_TAM_BLOCO) com
+ * um tokenizador escrito a mao, para a carga dos snapshots *.txt.
+ *
+ * lei_proxima devolve cada linha no proprio buffer do leitor (sem o '\n'
+ * e sem '\r' final), ja terminada em '\0' e alteravel: os campos sao
+ * cortados no lugar por lei_campo, sem copia. Uma linha maior que o
+ * buffer faz o buffer crescer, entao nao ha limite de tamanho de linha.
+ * O ponteiro vale ate a proxima chamada.
+ */
+
+#define LEITOR_TAM_BLOCO (1024 * 1024)
+
+typedef struct {
+    FILE* f;
+    char* buf;
+    size_t cap;
+    size_t ini;     // inicio do que ainda nao foi entregue
+    size_t fim;     // fim do que ja foi lido do arquivo
+    int eof;
+    int sem_quebra; // a ultima linha entregue acabou no fim do arquivo, sem '\n'
+} LeitorLinhas;
+
+// Abre o arquivo. 1 ok, 0 se nao abriu ou faltou memoria
+int lei_abrir(LeitorLinhas* l, const char* path);
+void lei_fechar(LeitorLinhas* l);
+// Proxima linha (len opcional recebe o tamanho) ou NULL no fim do arquivo
+char* lei_proxima(LeitorLinhas* l, size_t* len);
+
+// Corta o campo em *cursor no proximo ';' e avanca o cursor para depois
+// dele. O ultimo campo vai ate o fim da linha (cursor vira NULL).
+// Retorna NULL se os campos ja acabaram
+char* lei_campo(char** cursor);
+// O resto da linha como um campo so (pode conter ';'), ou NULL se acabou
+char* lei_resto(char** cursor);
+// Inteiro decimal com sinal ocupando o texto todo. 1 ok, 0 invalido
+int lei_int(const char* s, int* out);
+
+#endif
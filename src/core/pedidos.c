@@ -1,29 +1,102 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include "pedidos.h"
-#include "rollback.h"
 
 /* Inicializa a fila de pedidos */
-FilaPedidos* ped_inicializar() {
+FilaPedidos* ped_inicializar(const BancoReceitas* banco, PoolFixo* pool) {
     FilaPedidos* f = (FilaPedidos*) malloc(sizeof(FilaPedidos));
     if (f) {
         f->inicio = NULL;
         f->fim = NULL;
+        for (int n = 0; n < PED_NUM_PRIORIDADES; n++) {
+            f->niveis[n].inicio = f->niveis[n].fim = NULL;
+            f->niveis[n].qtd = 0;
+            f->espera[n] = 0;
+        }
         f->contador_pedidos = 0;
+        f->prox_id = 1;
+        f->espera_por_ing = NULL;
+        f->tam_espera = 0;
+        f->qtd_bloqueados = 0;
+        f->nos = NULL;
+        f->cap_nos = 0;
+        f->banco = banco;
+        f->estoque = NULL;
+        f->pool = pool;
+        int ok_id = hsh_inicializar(&f->slot_por_id, 64);
+        int ok_rec = hsh_inicializar(&f->pedidos_por_receita, 16);
+        if (!ok_id || !ok_rec) {
+            if (ok_id) hsh_liberar(&f->slot_por_id);
+            if (ok_rec) hsh_liberar(&f->pedidos_por_receita);
+            free(f);
+            return NULL;
+        }
     }
     return f;
 }
 
-/* Adiciona um pedido (receita) ao fim da fila */
-void ped_adicionar(FilaPedidos* fila, Receita* receita) {
-    if (!fila || !receita) return;
-    NoPedido* novo = (NoPedido*) malloc(sizeof(NoPedido));
-    if (!novo) return;
-    
+/* Soma 'delta' a contagem da receita; a chave sai do indice quando chega a zero */
+static int contar_receita(FilaPedidos* fila, int id_receita, int delta) {
+    int qtd = hsh_buscar(&fila->pedidos_por_receita, id_receita);
+    if (qtd < 0) qtd = 0;
+    qtd += delta;
+    if (qtd <= 0) {
+        hsh_remover(&fila->pedidos_por_receita, id_receita);
+        return 1;
+    }
+    return hsh_inserir(&fila->pedidos_por_receita, id_receita, qtd);
+}
+
+/* Devolve o no ao pool da fila (ou ao sistema, sem pool) */
+static void liberar_no(FilaPedidos* fila, NoPedido* no) {
+    if (fila->pool) pool_devolver(fila->pool, no);
+    else            free(no);
+}
+
+/* Adiciona um pedido (receita) com id conhecido ao fim da fila e do seu nivel */
+int ped_adicionar_com_id(FilaPedidos* fila, int id_pedido, Receita* receita, int prioridade) {
+    if (!fila || !receita) return 0;
+    if (prioridade < 0 || prioridade >= PED_NUM_PRIORIDADES) prioridade = PED_PRIO_NORMAL;
+    if (hsh_buscar(&fila->slot_por_id, id_pedido) >= 0) return 0;
+    Referencia ref = rec_referencia(fila->banco, receita->id);
+    if (ref.slot < 0) return 0; // receita fora do banco da fila
+    if (fila->contador_pedidos == fila->cap_nos) {
+        int nova_cap = fila->cap_nos ? fila->cap_nos * 2 : 64;
+        NoPedido** nos = (NoPedido**) realloc(fila->nos, sizeof(NoPedido*) * nova_cap);
+        if (!nos) return 0;
+        fila->nos = nos;
+        fila->cap_nos = nova_cap;
+    }
+    NoPedido* novo = fila->pool ? (NoPedido*) pool_alocar(fila->pool)
+                                : (NoPedido*) malloc(sizeof(NoPedido));
+    if (!novo) return 0;
+
+    int slot = fila->contador_pedidos;
+    if (!hsh_inserir(&fila->slot_por_id, id_pedido, slot)) {
+        liberar_no(fila, novo);
+        return 0;
+    }
+    if (!contar_receita(fila, receita->id, +1)) {
+        hsh_remover(&fila->slot_por_id, id_pedido);
+        liberar_no(fila, novo);
+        return 0;
+    }
+    fila->nos[slot] = novo;
+    novo->slot = slot;
     fila->contador_pedidos++;
-    novo->id_pedido = fila->contador_pedidos;
-    novo->receita = receita;
+    if (id_pedido >= fila->prox_id) fila->prox_id = id_pedido + 1;
+    novo->id_pedido = id_pedido;
+    novo->receita = ref;
+    novo->id_receita = receita->id;
+    novo->reservado = 0;
+    novo->prioridade = prioridade;
     novo->prox = NULL;
+    novo->ant = fila->fim;
+    novo->prox_nivel = NULL;
+    novo->bloqueado_por = 0;
+    novo->falta = 0;
+    novo->prox_espera = NULL;
+    novo->ant_espera = NULL;
 
     if (fila->fim == NULL) {
         fila->inicio = novo;
@@ -32,6 +105,237 @@ void ped_adicionar(FilaPedidos* fila, Receita* receita) {
         fila->fim->prox = novo;
         fila->fim = novo;
     }
+
+    NivelPedidos* nivel = &fila->niveis[prioridade];
+    novo->ant_nivel = nivel->fim;
+    if (nivel->fim == NULL) nivel->inicio = novo;
+    else                    nivel->fim->prox_nivel = novo;
+    nivel->fim = novo;
+    nivel->qtd++;
+    return id_pedido;
+}
+
+/* Tira o no da FIFO do seu nivel (a contagem do nivel fica com quem chama) */
+static void sair_do_nivel(FilaPedidos* fila, NoPedido* p) {
+    NivelPedidos* nivel = &fila->niveis[p->prioridade];
+    if (p->ant_nivel) p->ant_nivel->prox_nivel = p->prox_nivel;
+    else              nivel->inicio = p->prox_nivel;
+    if (p->prox_nivel) p->prox_nivel->ant_nivel = p->ant_nivel;
+    else               nivel->fim = p->ant_nivel;
+    p->prox_nivel = p->ant_nivel = NULL;
+}
+
+/*
+    voltar_ao_nivel
+        - Reinsere um pedido acordado na FIFO do nivel pela ordem de chegada
+          (os ids crescem com a chegada). Quem esta na frente dele e algum
+          outro acordado mais antigo, entao a busca para logo.
+ */
+static void voltar_ao_nivel(FilaPedidos* fila, NoPedido* p) {
+    NivelPedidos* nivel = &fila->niveis[p->prioridade];
+    NoPedido* depois = nivel->inicio;
+    while (depois && depois->id_pedido < p->id_pedido) depois = depois->prox_nivel;
+    p->prox_nivel = depois;
+    p->ant_nivel = depois ? depois->ant_nivel : nivel->fim;
+    if (p->ant_nivel) p->ant_nivel->prox_nivel = p;
+    else              nivel->inicio = p;
+    if (depois) depois->ant_nivel = p;
+    else        nivel->fim = p;
+}
+
+/* Adiciona um pedido (receita) ao fim da fila, gerando um id novo */
+int ped_adicionar_prio(FilaPedidos* fila, Receita* receita, int prioridade) {
+    if (!fila) return 0;
+    return ped_adicionar_com_id(fila, fila->prox_id, receita, prioridade);
+}
+
+int ped_adicionar(FilaPedidos* fila, Receita* receita) {
+    return ped_adicionar_prio(fila, receita, PED_PRIO_NORMAL);
+}
+
+/* Busca um pedido pelo id (hash id -> slot) */
+NoPedido* ped_buscar(const FilaPedidos* fila, int id_pedido) {
+    if (!fila) return NULL;
+    int slot = hsh_buscar(&fila->slot_por_id, id_pedido);
+    return slot < 0 ? NULL : fila->nos[slot];
+}
+
+Receita* ped_receita(const FilaPedidos* fila, const NoPedido* pedido) {
+    if (!fila || !pedido) return NULL;
+    return rec_resolver(fila->banco, pedido->receita);
+}
+
+int ped_pedidos_da_receita(const FilaPedidos* fila, int id_receita) {
+    if (!fila) return 0;
+    int qtd = hsh_buscar(&fila->pedidos_por_receita, id_receita);
+    return qtd < 0 ? 0 : qtd;
+}
+
+/* 
+    ped_proximo
+        - Normalmente a cabeca do nivel mais alto com pedidos. Um nivel mais
+          baixo que ja esperou PED_ENVELHECIMENTO atendimentos passa na
+          frente (o que esperou mais vence), para nao ficar parado para sempre.
+        - Estacionados estao fora das FIFOs: olhar so as cabecas basta.
+ */
+NoPedido* ped_proximo(const FilaPedidos* fila) {
+    if (!fila) return NULL;
+    int escolhido = -1;
+    for (int n = PED_NUM_PRIORIDADES - 1; n >= 0; n--) {
+        if (!fila->niveis[n].inicio) continue;
+        if (escolhido < 0) escolhido = n;
+        else if (fila->espera[n] >= PED_ENVELHECIMENTO && fila->espera[n] > fila->espera[escolhido])
+            escolhido = n;
+    }
+    return escolhido < 0 ? NULL : fila->niveis[escolhido].inicio;
+}
+
+/* Garante espera_por_ing[id_ingrediente] (tabela densa, cresce dobrando ate CAT_ID_MAXIMO) */
+static int garantir_espera(FilaPedidos* fila, int id_ingrediente) {
+    if (id_ingrediente > CAT_ID_MAXIMO) return 0;
+    if (id_ingrediente < fila->tam_espera) return 1;
+    int novo_tam = fila->tam_espera ? fila->tam_espera : 16;
+    while (novo_tam <= id_ingrediente) novo_tam *= 2;
+    if (novo_tam > CAT_ID_MAXIMO + 1) novo_tam = CAT_ID_MAXIMO + 1;
+    NoPedido** novo = (NoPedido**) realloc(fila->espera_por_ing, sizeof(NoPedido*) * novo_tam);
+    if (!novo) return 0;
+    for (int i = fila->tam_espera; i < novo_tam; i++) novo[i] = NULL;
+    fila->espera_por_ing = novo;
+    fila->tam_espera = novo_tam;
+    return 1;
+}
+
+/*
+    ped_bloquear
+        - O pedido continua na fila (e na listagem) mas sai da FIFO do nivel,
+          e portanto do ped_proximo, ate o ingrediente que faltou voltar a caber.
+ */
+int ped_bloquear(FilaPedidos* fila, NoPedido* pedido, int id_ingrediente, Quantidade falta) {
+    if (!fila || !pedido || pedido->bloqueado_por || id_ingrediente <= 0) return 0;
+    if (!garantir_espera(fila, id_ingrediente)) return 0;
+    sair_do_nivel(fila, pedido);
+    pedido->bloqueado_por = id_ingrediente;
+    pedido->falta = falta;
+    pedido->ant_espera = NULL;
+    pedido->prox_espera = fila->espera_por_ing[id_ingrediente];
+    if (pedido->prox_espera) pedido->prox_espera->ant_espera = pedido;
+    fila->espera_por_ing[id_ingrediente] = pedido;
+    fila->qtd_bloqueados++;
+    return 1;
+}
+
+/* Tira o pedido da lista de espera em que ele esta (se estiver) */
+static void sair_da_espera(FilaPedidos* fila, NoPedido* pedido) {
+    if (!pedido->bloqueado_por) return;
+    if (pedido->ant_espera) pedido->ant_espera->prox_espera = pedido->prox_espera;
+    else                    fila->espera_por_ing[pedido->bloqueado_por] = pedido->prox_espera;
+    if (pedido->prox_espera) pedido->prox_espera->ant_espera = pedido->ant_espera;
+    pedido->bloqueado_por = 0;
+    pedido->prox_espera = NULL;
+    pedido->ant_espera = NULL;
+    fila->qtd_bloqueados--;
+}
+
+/* So percorre a lista do ingrediente que mudou: os demais estacionados nem sao olhados */
+int ped_desbloquear(FilaPedidos* fila, int id_ingrediente, Quantidade disponivel) {
+    if (!fila || id_ingrediente <= 0 || id_ingrediente >= fila->tam_espera) return 0;
+    int acordados = 0;
+    NoPedido* p = fila->espera_por_ing[id_ingrediente];
+    while (p) {
+        NoPedido* prox = p->prox_espera;
+        if (p->falta <= disponivel) {
+            sair_da_espera(fila, p);
+            voltar_ao_nivel(fila, p);
+            acordados++;
+        }
+        p = prox;
+    }
+    return acordados;
+}
+
+/* Solta todos e remonta as FIFOs dos niveis numa passada pela lista principal */
+void ped_desbloquear_todos(FilaPedidos* fila) {
+    if (!fila || fila->qtd_bloqueados == 0) return;
+    for (int i = 0; i < fila->tam_espera; i++) fila->espera_por_ing[i] = NULL;
+    fila->qtd_bloqueados = 0;
+    for (int n = 0; n < PED_NUM_PRIORIDADES; n++)
+        fila->niveis[n].inicio = fila->niveis[n].fim = NULL;
+    for (NoPedido* p = fila->inicio; p; p = p->prox) {
+        NivelPedidos* nivel = &fila->niveis[p->prioridade];
+        p->bloqueado_por = 0;
+        p->prox_espera = p->ant_espera = NULL;
+        p->prox_nivel = NULL;
+        p->ant_nivel = nivel->fim;
+        if (nivel->fim) nivel->fim->prox_nivel = p;
+        else            nivel->inicio = p;
+        nivel->fim = p;
+    }
+}
+
+/* Observador do estoque: acorda quem espera o ingrediente que mudou */
+static void acordar_espera(void* ctx, int id_ingrediente) {
+    FilaPedidos* fila = ctx;
+    if (fila->qtd_bloqueados == 0) return;
+    ped_desbloquear(fila, id_ingrediente, est_disponivel(fila->estoque, id_ingrediente));
+}
+
+int ped_ligar_espera(FilaPedidos* fila, Estoque* est) {
+    if (!fila || !est) return 0;
+    fila->estoque = est;
+    return est_observar(est, acordar_espera, fila);
+}
+
+/*
+    desligar
+        - Tira o no (achado pelo hash) da lista principal e da FIFO do nivel
+          (ou da espera, se estacionado), sem percorrer nada. O ultimo slot de 'nos' ocupa a vaga.
+        - Retorna o no (ou NULL se o id nao esta na fila).
+ */
+static NoPedido* desligar(FilaPedidos* fila, int id_pedido) {
+    int slot = hsh_buscar(&fila->slot_por_id, id_pedido);
+    if (slot < 0) return NULL;
+    NoPedido* atual = fila->nos[slot];
+
+    if (atual->bloqueado_por) sair_da_espera(fila, atual); /* estacionado: fora do nivel */
+    else                      sair_do_nivel(fila, atual);
+    if (--fila->niveis[atual->prioridade].qtd == 0) fila->espera[atual->prioridade] = 0;
+    if (atual->ant) atual->ant->prox = atual->prox;
+    else            fila->inicio = atual->prox;
+    if (atual->prox) atual->prox->ant = atual->ant;
+    else             fila->fim = atual->ant;
+
+    /* O ultimo slot ocupa a vaga; a chave dele ja existe, so muda o valor */
+    fila->contador_pedidos--;
+    hsh_remover(&fila->slot_por_id, id_pedido);
+    NoPedido* ultimo = fila->nos[fila->contador_pedidos];
+    if (ultimo != atual) {
+        fila->nos[slot] = ultimo;
+        ultimo->slot = slot;
+        hsh_inserir(&fila->slot_por_id, ultimo->id_pedido, slot);
+    }
+    contar_receita(fila, atual->id_receita, -1);
+    return atual;
+}
+
+/* Remove um pedido de qualquer posicao da fila (cancelamento) */
+int ped_remover(FilaPedidos* fila, int id_pedido) {
+    if (!fila) return 0;
+    NoPedido* no = desligar(fila, id_pedido);
+    if (!no) return 0;
+    liberar_no(fila, no);
+    return 1;
+}
+
+/* Remove o pedido atendido: zera a espera do seu nivel e envelhece os niveis abaixo que tem pedidos */
+int ped_concluir(FilaPedidos* fila, int id_pedido) {
+    if (!fila) return 0;
+    NoPedido* no = desligar(fila, id_pedido);
+    if (!no) return 0;
+    fila->espera[no->prioridade] = 0;
+    for (int n = 0; n < no->prioridade; n++)
+        if (fila->niveis[n].qtd) fila->espera[n]++;
+    liberar_no(fila, no);
+    return 1;
 }
 
 /* Lista os pedidos pendentes na fila */
@@ -43,28 +347,89 @@ void ped_listar(const FilaPedidos* fila) {
     printf("\n--- FILA DE PEDIDOS (%d pendentes) ---\n", fila->contador_pedidos);
     NoPedido* atual = fila->inicio;
     while (atual) {
-        printf("Pedido #%d: %s\n", atual->id_pedido, atual->receita->nome);
+        const Receita* r = ped_receita(fila, atual);
+        printf("Pedido #%d: %s\n", atual->id_pedido, r ? r->nome : "[Receita removida]");
         atual = atual->prox;
     }
     printf("--------------------------------------\n");
 }
 
+#define LOTE_CONFERENCIA 32
+
+/*
+    ped_ingrediente_em_falta
+        - Cada ingrediente aparece uma vez no vetor, entao conferir um a um
+          equivale a retirar todos.
+        - Em lotes: junta o disponivel e o exigido de cada ingrediente em
+          dois arrays e compara o lote de uma vez (qtd_primeiro_insuficiente).
+          Item fora do estoque ou exigencia <= 0 entra como tem -1 / precisa 0,
+          a mesma recusa do est_pode_remover, na mesma ordem.
+ */
+const IngredienteReceita* ped_ingrediente_em_falta(const Receita* receita, const Estoque* est) {
+    if (!receita) return NULL;
+    Quantidade tem[LOTE_CONFERENCIA], precisa[LOTE_CONFERENCIA];
+    const IngredienteReceita* itens = receita->ingredientes.itens;
+    int qtd = receita->ingredientes.qtd;
+    for (int ini = 0; ini < qtd; ini += LOTE_CONFERENCIA) {
+        int n = qtd - ini < LOTE_CONFERENCIA ? qtd - ini : LOTE_CONFERENCIA;
+        for (int k = 0; k < n; k++) {
+            const IngredienteReceita* ing = &itens[ini + k];
+            int idx = est_buscar_indice(est, ing->id_ingrediente);
+            if (idx == -1 || ing->quantidade <= 0) {
+                tem[k] = -1;
+                precisa[k] = 0;
+            } else {
+                tem[k] = est->itens[idx].quantidade - est->itens[idx].reservado;
+                precisa[k] = ing->quantidade;
+            }
+        }
+        int falta = qtd_primeiro_insuficiente(tem, precisa, n);
+        if (falta >= 0) return &itens[ini + falta];
+    }
+    return NULL;
+}
+
 /* 
-   Processa o proximo pedido com logica de rollback (transacional).
-   Tenta retirar todos os ingredientes; se faltar um, devolve tudo.
+   Processa o proximo pedido em duas fases (transacional):
+   1. Verificacao: so le o estoque; se faltar um ingrediente, nada e alterado.
+      Com pular_bloqueados o pedido e estacionado na espera do ingrediente
+      e a verificacao passa para o proximo livre.
+   2. Baixa: retira cada ingrediente. A pilha de rollback fica so como guarda
+      caso uma retirada falhe mesmo assim; ai devolve tudo.
 */
-int ped_processar_proximo(FilaPedidos* fila, Estoque* est) {
-    if (!fila || !fila->inicio || !est) return 0;
-
-    NoPedido* pedido = fila->inicio;
-    Receita* r = pedido->receita;
-    
-    PilhaRollback* rb = rb_criar();
-    NoIngrediente* ing = r->ingredientes;
+int ped_processar_proximo(FilaPedidos* fila, Estoque* est, PilhaRollback* rb, int pular_bloqueados) {
+    if (!fila || !fila->inicio || !est || !rb) return 0;
+
+    NoPedido* pedido;
+    Receita* r;
+    for (;;) {
+        pedido = ped_proximo(fila);
+        if (!pedido) {
+            printf("Nenhum pedido livre: %d aguardando estoque.\n", fila->qtd_bloqueados);
+            return 0;
+        }
+        r = ped_receita(fila, pedido);
+        if (!r) {
+            printf("Pedido #%d descartado: receita removida.\n", pedido->id_pedido);
+            ped_remover(fila, pedido->id_pedido);
+            return 0;
+        }
+
+        // Fase 1: verificacao (sem escrita)
+        const IngredienteReceita* falta = ped_ingrediente_em_falta(r, est);
+        if (!falta) break;
+        printf("Estoque insuficiente para o Pedido #%d (%s).\n", pedido->id_pedido, r->nome);
+        if (!pular_bloqueados || !ped_bloquear(fila, pedido, falta->id_ingrediente, falta->quantidade))
+            return 0;
+        printf("Pedido #%d aguarda o ingrediente %d; tentando o proximo.\n",
+               pedido->id_pedido, falta->id_ingrediente);
+    }
+
     int sucesso = 1;
 
-    // Transacao: tenta retirar cada ingrediente do estoque
-    while (ing) {
+    // Fase 2: baixa de cada ingrediente do estoque
+    for (int k = 0; k < r->ingredientes.qtd; k++) {
+        const IngredienteReceita* ing = &r->ingredientes.itens[k];
         if (est_remover(est, ing->id_ingrediente, ing->quantidade)) {
             // Se retirou, registra na pilha para caso precise desfazer
             rb_push(rb, ing->id_ingrediente, ing->quantidade);
@@ -72,7 +437,6 @@ int ped_processar_proximo(FilaPedidos* fila, Estoque* est) {
             sucesso = 0; // Faltou ingrediente!
             break;
         }
-        ing = ing->prox;
     }
 
     if (!sucesso) {
@@ -82,16 +446,10 @@ int ped_processar_proximo(FilaPedidos* fila, Estoque* est) {
     } else {
         // Sucesso: pedido concluido, remove da fila
         printf("Pedido #%d (%s) processado com sucesso!\n", pedido->id_pedido, r->nome);
-        
-        fila->inicio = pedido->prox;
-        if (fila->inicio == NULL) {
-            fila->fim = NULL;
-        }
-        free(pedido);
-        fila->contador_pedidos--;
+        ped_concluir(fila, pedido->id_pedido);
     }
 
-    rb_liberar(rb); // Limpa a pilha temporaria
+    rb_limpar(rb); // Esvazia a pilha para o proximo pedido
     return sucesso;
 }
 
@@ -102,7 +460,11 @@ void ped_liberar(FilaPedidos* fila) {
     while (atual) {
         NoPedido* temp = atual;
         atual = atual->prox;
-        free(temp);
+        liberar_no(fila, temp);
     }
+    free(fila->espera_por_ing);
+    free(fila->nos);
+    hsh_liberar(&fila->slot_por_id);
+    hsh_liberar(&fila->pedidos_por_receita);
     free(fila);
 }
@@ -3,27 +3,121 @@
 
 #include "receitas.h"
 #include "estoque.h"
+#include "rollback.h"
+#include "pool.h"
+#include "hash.h"
+
+/* Niveis de prioridade: o maior e atendido primeiro */
+#define PED_PRIO_BAIXA   0
+#define PED_PRIO_NORMAL  1
+#define PED_PRIO_ALTA    2
+#define PED_NUM_PRIORIDADES 3
+
+/* Envelhecimento: um nivel com pedidos esperando passa na frente depois
+   de ver PED_ENVELHECIMENTO pedidos de nivel maior serem atendidos */
+#define PED_ENVELHECIMENTO 4
 
 typedef struct NoPedido {
     int id_pedido;
-    Receita* receita;
-    struct NoPedido* prox;
+    Referencia receita;     // resolvida por ped_receita (NULL se a receita saiu do banco)
+    int id_receita;
+    int reservado;          // 1 se os ingredientes ja estao reservados no estoque
+    int prioridade;         // PED_PRIO_*
+    struct NoPedido* prox;        // ordem de chegada (todos os niveis)
+    struct NoPedido* ant;
+    struct NoPedido* prox_nivel;  // proximo do mesmo nivel (FIFO do nivel; estacionados ficam fora)
+    struct NoPedido* ant_nivel;
+    int bloqueado_por;      // ingrediente que faltou (0 = livre para tentar)
+    Quantidade falta;       // quantidade dele que a receita exige
+    struct NoPedido* prox_espera; // proximo na lista de espera do ingrediente
+    struct NoPedido* ant_espera;
+    int slot;               // posicao em FilaPedidos.nos
 } NoPedido;
 
 typedef struct {
     NoPedido* inicio;
     NoPedido* fim;
-    int contador_pedidos;
+    int qtd;            // pedidos do nivel, estacionados inclusive (envelhecimento)
+} NivelPedidos;
+
+/*
+ * Fila com prioridade em multi-lista: a lista principal (inicio/fim/prox)
+ * guarda todos os pedidos em ordem de chegada (listagem e arquivos) e cada
+ * nivel tem sua propria FIFO (prox_nivel). ped_proximo escolhe o nivel.
+ *
+ * As tres listas sao duplamente encadeadas e o no e achado pelo id via
+ * hash (id -> slot em 'nos'), entao cancelar um pedido nao percorre nada.
+ * A contagem de pedidos por receita deixa DEL_RECEITA conferir o uso em O(1).
+ *
+ * Um pedido estacionado (ped_bloquear) sai da FIFO do seu nivel e fica so
+ * na lista principal e na espera do ingrediente; ao ser acordado volta ao
+ * nivel na posicao de chegada. Assim ped_proximo nunca passa por ele.
+ */
+typedef struct {
+    NoPedido* inicio;
+    NoPedido* fim;
+    NivelPedidos niveis[PED_NUM_PRIORIDADES];
+    int espera[PED_NUM_PRIORIDADES]; // atendimentos de nivel maior desde o ultimo deste nivel
+    int contador_pedidos; // pedidos pendentes na fila
+    int prox_id;          // proximo id_pedido (ids nao se repetem)
+
+    /* Pedidos estacionados por falta de estoque, por ingrediente (indice = id) */
+    NoPedido** espera_por_ing;
+    int tam_espera;
+    int qtd_bloqueados;
+
+    /* Acesso direto */
+    NoPedido** nos;                  // nos[slot], slot = 0 .. contador_pedidos-1
+    int cap_nos;
+    IndiceHash slot_por_id;          // id_pedido -> slot
+    IndiceHash pedidos_por_receita;  // id_receita -> pedidos na fila (so > 0)
+
+    const BancoReceitas* banco; // onde as referencias dos pedidos sao resolvidas
+    const Estoque* estoque;     // consultado ao acordar estacionados (ped_ligar_espera)
+    PoolFixo* pool;       // de onde vem os nos (NULL = malloc)
 } FilaPedidos;
 
-FilaPedidos* ped_inicializar();
+// Cria a fila vazia sobre o banco de receitas. pool pode ser NULL
+FilaPedidos* ped_inicializar(const BancoReceitas* banco, PoolFixo* pool);
 void ped_liberar(FilaPedidos* fila);
 
-void ped_adicionar(FilaPedidos* fila, Receita* receita);
+// Enfileira com prioridade normal e retorna o id do pedido (0 se falha)
+int ped_adicionar(FilaPedidos* fila, Receita* receita);
+// Enfileira no nivel informado (PED_PRIO_*). Retorna id ou 0
+int ped_adicionar_prio(FilaPedidos* fila, Receita* receita, int prioridade);
+// Enfileira com id conhecido (carga de arquivo / journal). Retorna id ou 0
+// (tambem 0 se o id ja esta na fila)
+int ped_adicionar_com_id(FilaPedidos* fila, int id_pedido, Receita* receita, int prioridade);
+NoPedido* ped_buscar(const FilaPedidos* fila, int id_pedido);
+// Receita do pedido, ou NULL se ela foi removida do banco depois de enfileirado
+Receita* ped_receita(const FilaPedidos* fila, const NoPedido* pedido);
+// Quantos pedidos da receita estao na fila
+int ped_pedidos_da_receita(const FilaPedidos* fila, int id_receita);
+// Proximo pedido a ser atendido (prioridade + envelhecimento), ou NULL.
+// Os estacionados nao contam
+NoPedido* ped_proximo(const FilaPedidos* fila);
+// Estaciona o pedido na espera do ingrediente que faltou. Retorna 0 se faltou memoria
+int ped_bloquear(FilaPedidos* fila, NoPedido* pedido, int id_ingrediente, Quantidade falta);
+// Registra a fila como observadora do estoque: cada mudanca de quantidade
+// acorda quem espera aquele ingrediente e passou a caber. 0 se nao coube
+int ped_ligar_espera(FilaPedidos* fila, Estoque* est);
+// Libera os pedidos que esperam o ingrediente e cabem em 'disponivel'. Retorna quantos
+int ped_desbloquear(FilaPedidos* fila, int id_ingrediente, Quantidade disponivel);
+// Libera todos os pedidos estacionados (ex: receitas mudaram)
+void ped_desbloquear_todos(FilaPedidos* fila);
+// Retira o pedido da fila (cancelamento). Retorna 1 sucesso, 0 se nao existe
+int ped_remover(FilaPedidos* fila, int id_pedido);
+// Retira o pedido como atendido (conta para o envelhecimento dos outros niveis)
+int ped_concluir(FilaPedidos* fila, int id_pedido);
 void ped_listar(const FilaPedidos* fila);
 
-// Processa o pedido mais antigo com lógica de rollback
-// Retorna 1 sucesso / 0 falha
-int ped_processar_proximo(FilaPedidos* fila, Estoque* est);
+// Verificacao so de leitura: o primeiro ingrediente da receita que o estoque
+// nao cobre, ou NULL se da para fazer (a baixa logo depois nao falha)
+const IngredienteReceita* ped_ingrediente_em_falta(const Receita* receita, const Estoque* est);
+
+// Processa o proximo pedido em duas fases (verifica, depois baixa), usando a
+// pilha 'rb' (vazia na entrada e na saida). Com pular_bloqueados, o pedido
+// sem estoque e estacionado e o proximo e tentado. Retorna 1 sucesso / 0 falha
+int ped_processar_proximo(FilaPedidos* fila, Estoque* est, PilhaRollback* rb, int pular_bloqueados);
 
 #endif
@@ -1,50 +1,80 @@
+/* pthread com -std=c99 precisa deste define (como o mmap em persistencia_bin.c) */
+#define _POSIX_C_SOURCE 200809L
+
 #include "persistencia.h"
 #include "utils.h"
+#include "arena.h"
+#include "leitor.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdarg.h>
+
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+
+/* 
+    Snapshots são gravados em "<arquivo>.tmp" e renomeados no fim:
+    se o processo cair no meio da escrita, o arquivo anterior continua inteiro.
+ */
+static FILE* abrir_snapshot(const char* path, char* tmp, size_t tam) {
+    snprintf(tmp, tam, "%s.tmp", path);
+    return fopen(tmp, "w");
+}
+
+static int fechar_snapshot(FILE* f, const char* tmp, const char* path) {
+    if (fclose(f) != 0) {
+        remove(tmp);
+        return 0;
+    }
+#ifdef _WIN32
+    remove(path); /* rename no Windows não sobrescreve */
+#endif
+    return rename(tmp, path) == 0;
+}
 
 /* --- CATALOGO --- */
 
 int pers_salvar_catalogo(const CatalogoIngredientes* cat) {
     if (!cat) return 0;
-    FILE* f = fopen(PATH_INGREDIENTES, "w");
+    char tmp[256];
+    FILE* f = abrir_snapshot(PATH_INGREDIENTES, tmp, sizeof(tmp));
     if (!f) return 0;
 
-    for (size_t i = 0; i < cat->qtd_atual; i++) {
+    for (size_t i = 0; i < cat->qtd_slots; i++) {
+        if (cat->itens[i].id == 0) continue; // lapide
         fprintf(f, "%d;%s;%s\n", cat->itens[i].id, cat->itens[i].nome, cat->itens[i].unidade);
     }
 
-    fclose(f);
-    return 1;
+    return fechar_snapshot(f, tmp, PATH_INGREDIENTES);
 }
 
+/*
+    Carga dos snapshots *.txt: LeitorLinhas entrega cada linha inteira (sem
+    limite de tamanho) e os campos sao cortados no lugar por lei_campo.
+    Campo vazio invalida a linha, como acontecia com o strtok.
+ */
 int pers_carregar_catalogo(CatalogoIngredientes* cat) {
     if (!cat) return 0;
-    FILE* f = fopen(PATH_INGREDIENTES, "r");
-    if (!f) return 0;
-
-    char linha[512];
-    int max_id = 0;
-
-    while (fgets(linha, sizeof(linha), f)) {
-        utl_chomp(linha);
-        if (strlen(linha) == 0) continue;
-
-        char* id_str = strtok(linha, ";");
-        char* nome = strtok(NULL, ";");
-        char* unidade = strtok(NULL, ";");
+    LeitorLinhas l;
+    if (!lei_abrir(&l, PATH_INGREDIENTES)) return 0;
+
+    char* linha;
+    while ((linha = lei_proxima(&l, NULL))) {
+        char* cursor = linha;
+        char* id_str = lei_campo(&cursor);
+        char* nome = lei_campo(&cursor);
+        char* unidade = lei_campo(&cursor);
+        int id;
 
-        if (id_str && nome && unidade) {
-            int id = atoi(id_str);
-            cat_cadastrar(cat, nome, unidade);
-            // Sobrescreve o ID gerado pelo automático para manter o do arquivo
-            cat->itens[cat->qtd_atual - 1].id = id;
-            if (id >= cat->prox_id) cat->prox_id = id + 1;
+        if (nome && *nome && unidade && *unidade && lei_int(id_str, &id)) {
+            // Mantém o ID do arquivo (e o índice hash do catálogo em sincronia)
+            cat_cadastrar_com_id(cat, id, nome, unidade);
         }
     }
 
-    fclose(f);
+    lei_fechar(&l);
     return 1;
 }
 
@@ -52,33 +82,38 @@ int pers_carregar_catalogo(CatalogoIngredientes* cat) {
 
 int pers_salvar_estoque(const Estoque* estoque) {
     if (!estoque) return 0;
-    FILE* f = fopen(PATH_ESTOQUE, "w");
+    char tmp[256];
+    FILE* f = abrir_snapshot(PATH_ESTOQUE, tmp, sizeof(tmp));
     if (!f) return 0;
 
-    for (int i = 0; i < estoque->qtd_atual; i++) {
-        fprintf(f, "%d;%.2f\n", estoque->itens[i].id_ingrediente, estoque->itens[i].quantidade);
+    for (int i = 0; i < estoque->qtd_slots; i++) {
+        if (estoque->itens[i].id_ingrediente < 0) continue; // lapide
+        char txt[QTD_TEXTO_MAX];
+        fprintf(f, "%d;%s\n", estoque->itens[i].id_ingrediente,
+                qtd_formatar(estoque->itens[i].quantidade, txt, sizeof(txt)));
     }
 
-    fclose(f);
-    return 1;
+    return fechar_snapshot(f, tmp, PATH_ESTOQUE);
 }
 
 int pers_carregar_estoque(Estoque* estoque) {
     if (!estoque) return 0;
-    FILE* f = fopen(PATH_ESTOQUE, "r");
-    if (!f) return 0;
-
-    char linha[256];
-    while (fgets(linha, sizeof(linha), f)) {
-        utl_chomp(linha);
+    LeitorLinhas l;
+    if (!lei_abrir(&l, PATH_ESTOQUE)) return 0;
+
+    char* linha;
+    while ((linha = lei_proxima(&l, NULL))) {
+        char* cursor = linha;
+        char* id_str = lei_campo(&cursor);
+        char* qtd_str = lei_campo(&cursor);
         int id;
-        float qtd;
-        if (sscanf(linha, "%d;%f", &id, &qtd) == 2) {
+        Quantidade qtd;
+        if (qtd_str && lei_int(id_str, &id) && qtd_ler(qtd_str, &qtd)) {
             est_adicionar(estoque, id, qtd);
         }
     }
 
-    fclose(f);
+    lei_fechar(&l);
     return 1;
 }
 
@@ -86,101 +121,470 @@ int pers_carregar_estoque(Estoque* estoque) {
 
 int pers_salvar_receitas(const BancoReceitas* banco) {
     if (!banco) return 0;
-    FILE* f = fopen(PATH_RECEITAS, "w");
+    char tmp[256];
+    FILE* f = abrir_snapshot(PATH_RECEITAS, tmp, sizeof(tmp));
     if (!f) return 0;
 
-    for (int i = 0; i < banco->qtd_atual; i++) {
+    for (int i = 0; i < banco->qtd_slots; i++) {
         Receita* r = banco->vetor[i];
+        if (!r) continue; // lapide
         // Formato: [R];id;nome;preparo
         fprintf(f, "[R];%d;%s;%s\n", r->id, r->nome, r->modo_preparo);
         
-        NoIngrediente* ing = r->ingredientes;
-        while (ing) {
+        for (int k = 0; k < r->ingredientes.qtd; k++) {
             // Formato: [I];id_ingrediente;quantidade
-            fprintf(f, "[I];%d;%.2f\n", ing->id_ingrediente, ing->quantidade);
-            ing = ing->prox;
+            const IngredienteReceita* ing = &r->ingredientes.itens[k];
+            char txt[QTD_TEXTO_MAX];
+            fprintf(f, "[I];%d;%s\n", ing->id_ingrediente, qtd_formatar(ing->quantidade, txt, sizeof(txt)));
         }
     }
 
-    fclose(f);
-    return 1;
+    return fechar_snapshot(f, tmp, PATH_RECEITAS);
 }
 
+/* O modo de preparo e o resto da linha: pode conter ';' (o strtok cortava ali) */
 int pers_carregar_receitas(BancoReceitas* banco) {
     if (!banco) return 0;
-    FILE* f = fopen(PATH_RECEITAS, "r");
-    if (!f) return 0;
+    LeitorLinhas l;
+    if (!lei_abrir(&l, PATH_RECEITAS)) return 0;
 
-    char linha[1024];
     Receita* receita_atual = NULL;
-
-    while (fgets(linha, sizeof(linha), f)) {
-        utl_chomp(linha);
-        if (strlen(linha) == 0) continue;
-
-        char* tipo = strtok(linha, ";");
-        if (!tipo) continue;
+    char* linha;
+    while ((linha = lei_proxima(&l, NULL))) {
+        char* cursor = linha;
+        char* tipo = lei_campo(&cursor);
 
         if (strcmp(tipo, "[R]") == 0) {
-            char* id_str = strtok(NULL, ";");
-            char* nome = strtok(NULL, ";");
-            char* preparo = strtok(NULL, ";");
-
-            if (id_str && nome) {
-                int id = atoi(id_str);
-                int novo_id = rec_cadastrar(banco, nome, preparo);
-                receita_atual = rec_buscar_id(banco, novo_id);
-                if (receita_atual) {
-                    receita_atual->id = id;
-                    if (id >= banco->prox_id) banco->prox_id = id + 1;
-                }
+            char* id_str = lei_campo(&cursor);
+            char* nome = lei_campo(&cursor);
+            char* preparo = lei_resto(&cursor);
+            int id;
+
+            receita_atual = NULL;
+            if (nome && *nome && lei_int(id_str, &id)) {
+                id = rec_cadastrar_com_id(banco, id, nome, preparo);
+                receita_atual = id ? rec_buscar_id(banco, id) : NULL;
             }
         } else if (strcmp(tipo, "[I]") == 0 && receita_atual) {
-            char* id_ing_str = strtok(NULL, ";");
-            char* qtd_str = strtok(NULL, ";");
-            if (id_ing_str && qtd_str) {
-                ing_adicionar(&receita_atual->ingredientes, atoi(id_ing_str), atof(qtd_str));
-            }
+            char* id_ing_str = lei_campo(&cursor);
+            char* qtd_str = lei_campo(&cursor);
+            int id_ing;
+            Quantidade qtd;
+            /* Pelo banco, para manter o indice ingrediente -> receitas */
+            if (qtd_str && lei_int(id_ing_str, &id_ing) && qtd_ler(qtd_str, &qtd))
+                rec_add_ingrediente(banco, receita_atual->id, id_ing, qtd);
         }
     }
 
-    fclose(f);
+    lei_fechar(&l);
     return 1;
 }
 
-/* --- PEDIDOS (Opcional) --- */
+/* --- PEDIDOS --- */
 
 int pers_salvar_pedidos(const FilaPedidos* fila) {
     if (!fila) return 0;
-    FILE* f = fopen(PATH_PEDIDOS, "w");
+    char tmp[256];
+    FILE* f = abrir_snapshot(PATH_PEDIDOS, tmp, sizeof(tmp));
     if (!f) return 0;
 
     NoPedido* atual = fila->inicio;
     while (atual) {
-        // Salva apenas o ID da receita na fila
-        fprintf(f, "%d\n", atual->receita->id);
+        // Formato: id_receita;id_pedido;prioridade (o id do pedido é estável entre reinícios)
+        if (ped_receita(fila, atual))
+            fprintf(f, "%d;%d;%d\n", atual->id_receita, atual->id_pedido, atual->prioridade);
         atual = atual->prox;
     }
 
-    fclose(f);
-    return 1;
+    return fechar_snapshot(f, tmp, PATH_PEDIDOS);
 }
 
 int pers_carregar_pedidos(FilaPedidos* fila, BancoReceitas* banco) {
     if (!fila || !banco) return 0;
-    FILE* f = fopen(PATH_PEDIDOS, "r");
-    if (!f) return 0;
-
-    char linha[64];
-    while (fgets(linha, sizeof(linha), f)) {
-        utl_chomp(linha);
-        int id_rec = atoi(linha);
+    LeitorLinhas l;
+    if (!lei_abrir(&l, PATH_PEDIDOS)) return 0;
+
+    char* linha;
+    while ((linha = lei_proxima(&l, NULL))) {
+        char* cursor = linha;
+        int id_rec, id_ped, prio = PED_PRIO_NORMAL;
+        if (!lei_int(lei_campo(&cursor), &id_rec)) continue;
+        int tem_id = lei_int(lei_campo(&cursor), &id_ped);
+        if (tem_id && !lei_int(lei_campo(&cursor), &prio)) prio = PED_PRIO_NORMAL;
         Receita* r = rec_buscar_id(banco, id_rec);
-        if (r) {
-            ped_adicionar(fila, r);
+        if (r && tem_id) {
+            ped_adicionar_com_id(fila, id_ped, r, prio); // sem o 3º campo: prioridade normal
+        } else if (r) {
+            ped_adicionar(fila, r); // formato antigo: só o id da receita
         }
     }
 
+    lei_fechar(&l);
+    return 1;
+}
+
+/* --- CARGA DOS *.txt EM PARALELO --- */
+
+typedef struct {
+    CatalogoIngredientes* cat;
+    BancoReceitas* banco;
+    int catalogo_ok;
+} CargaTexto;
+
+static void* carregar_catalogo_tarefa(void* arg) {
+    CargaTexto* c = arg;
+    c->catalogo_ok = pers_carregar_catalogo(c->cat);
+    return NULL;
+}
+
+static void* carregar_receitas_tarefa(void* arg) {
+    CargaTexto* c = arg;
+    pers_carregar_receitas(c->banco);
+    return NULL;
+}
+
+/*
+    pers_carregar_texto
+        - Catalogo e receitas em threads proprias e o estoque na thread que
+          chamou; os tres nao se tocam durante a carga. Os pedidos vem depois
+          do join, porque precisam das receitas.
+        - Catalogo e banco dividem a arena de textos do AppContext, que nao
+          e thread-safe: durante a carga as receitas escrevem numa arena
+          propria, absorvida pela do banco no fim (arena_absorver).
+        - Os observadores do estoque leem outras estruturas: o cache de
+          producao le o indice invertido do banco, que a thread das receitas
+          esta escrevendo (e realocando). Por isso os avisos do estoque ficam
+          suspensos ate o join e so entao cada item e avisado uma vez.
+        - Sem pthread (Windows) ou se a thread nao sobe, carrega em serie.
+ */
+int pers_carregar_texto(CatalogoIngredientes* cat, BancoReceitas* banco,
+                        Estoque* estoque, FilaPedidos* fila) {
+    CargaTexto c = { cat, banco, 0 };
+#ifndef _WIN32
+    ArenaStrings arena_receitas;
+    ArenaStrings* arena_banco = banco ? banco->arena : NULL;
+    arena_iniciar(&arena_receitas);
+    if (arena_banco) banco->arena = &arena_receitas;
+
+    pthread_t t_cat, t_rec;
+    est_suspender_avisos(estoque);
+    int em_thread_cat = pthread_create(&t_cat, NULL, carregar_catalogo_tarefa, &c) == 0;
+    int em_thread_rec = pthread_create(&t_rec, NULL, carregar_receitas_tarefa, &c) == 0;
+    pers_carregar_estoque(estoque);
+    if (em_thread_cat) pthread_join(t_cat, NULL);
+    else carregar_catalogo_tarefa(&c);
+    if (em_thread_rec) pthread_join(t_rec, NULL);
+    else carregar_receitas_tarefa(&c);
+    est_retomar_avisos(estoque);
+
+    if (arena_banco) {
+        banco->arena = arena_banco;
+        arena_absorver(arena_banco, &arena_receitas);
+    }
+#else
+    carregar_catalogo_tarefa(&c);
+    carregar_receitas_tarefa(&c);
+    pers_carregar_estoque(estoque);
+#endif
+    pers_carregar_pedidos(fila, banco);
+    return c.catalogo_ok;
+}
+
+/* --- JOURNAL --- */
+
+/* 
+    Formato dos registros (um por linha, campos separados por ';'):
+        C+;id;nome;unidade      C-;id
+        E=;id;quantidade        E-;id
+        R+;id;nome;preparo      R-;id
+        I=;id_rec;id_ing;qtd    I-;id_rec;id_ing
+        P+;id_pedido;id_rec;prioridade   P-;id_pedido
+        T{  ...  T}             (transação: aplicada só se fechada)
+
+    Nos textos (nome, unidade, preparo) ';' e '\\' saem precedidos de '\\',
+    e quebras de linha viram "\\n" / "\\r": cada registro continua numa
+    linha só e com o número certo de campos.
+ */
+
+static FILE* journal = NULL;
+static long journal_registros = 0;
+static int journal_em_transacao = 0;
+static int journal_t_gravado = 0;   /* "T{" da transação atual já foi escrito */
+
+/* Dentro de transação, o primeiro registro abre o "T{" */
+static void jrn_inicio_registro() {
+    if (journal_em_transacao && !journal_t_gravado) {
+        fputs("T{\n", journal);
+        journal_registros++;
+        journal_t_gravado = 1;
+    }
+}
+
+static void jrn_fim_registro() {
+    fputc('\n', journal);
+    journal_registros++;
+    if (journal_em_transacao == 0) fflush(journal);
+}
+
+static void jrn_registrar(const char* fmt, ...) {
+    if (!journal) return;
+    jrn_inicio_registro();
+    va_list ap;
+    va_start(ap, fmt);
+    vfprintf(journal, fmt, ap);
+    va_end(ap);
+    jrn_fim_registro();
+}
+
+/* Campo de texto escapado (ver o formato acima) */
+static void jrn_escrever_texto(const char* s) {
+    for (; *s; s++) {
+        if (*s == ';' || *s == '\\') { fputc('\\', journal); fputc(*s, journal); }
+        else if (*s == '\n') fputs("\\n", journal);
+        else if (*s == '\r') fputs("\\r", journal);
+        else fputc(*s, journal);
+    }
+}
+
+/* Registros "tipo;id;texto;texto" (C+ e R+) */
+static void jrn_registrar_textos(const char* tipo, int id, const char* a, const char* b) {
+    if (!journal) return;
+    jrn_inicio_registro();
+    fprintf(journal, "%s;%d;", tipo, id);
+    jrn_escrever_texto(a);
+    fputc(';', journal);
+    jrn_escrever_texto(b);
+    jrn_fim_registro();
+}
+
+int pers_journal_abrir() {
+    if (journal) return 1;
+    journal = fopen(PATH_JOURNAL, "a");
+    return journal != NULL;
+}
+
+void pers_journal_fechar() {
+    if (!journal) return;
+    fclose(journal);
+    journal = NULL;
+}
+
+int pers_journal_precisa_compactar() {
+    if (!journal) return 0;
+    return journal_registros >= JOURNAL_LIMITE_REGISTROS || ftell(journal) >= JOURNAL_LIMITE_BYTES;
+}
+
+static int arquivo_existe(const char* path) {
+    FILE* f = fopen(path, "rb");
+    if (!f) return 0;
     fclose(f);
     return 1;
 }
+
+int pers_carregar_tudo(CatalogoIngredientes* cat, BancoReceitas* banco,
+                       Estoque* estoque, FilaPedidos* fila) {
+    if (!pers_carregar_binario(PATH_SNAPSHOT_BIN, cat, banco, estoque, fila))
+        pers_carregar_texto(cat, banco, estoque, fila);
+    return pers_journal_reaplicar(cat, banco, estoque, fila);
+}
+
+int pers_compactar(const CatalogoIngredientes* cat, const BancoReceitas* banco,
+                   const Estoque* estoque, const FilaPedidos* fila) {
+    int ok = pers_salvar_catalogo(cat)
+          && pers_salvar_receitas(banco)
+          && pers_salvar_estoque(estoque)
+          && pers_salvar_pedidos(fila);
+    /* Snapshot binário em uso: regrava junto, senão ficaria à frente dos *.txt */
+    if (ok && arquivo_existe(PATH_SNAPSHOT_BIN))
+        ok = pers_exportar_binario(PATH_SNAPSHOT_BIN, cat, banco, estoque, fila);
+    if (!ok) return 0; /* journal fica como está: nada se perde */
+
+    /* Snapshots em dia: o journal pode ser esvaziado */
+    int estava_aberto = journal != NULL;
+    pers_journal_fechar();
+    FILE* f = fopen(PATH_JOURNAL, "w");
+    if (f) fclose(f);
+    journal_registros = 0;
+    if (estava_aberto) pers_journal_abrir();
+    return 1;
+}
+
+/* Transações podem aninhar (ex: PROCESSAR_PEDIDO dentro de um BATCH):
+   só a mais externa grava os marcadores, e só se teve algum registro */
+void pers_jrn_transacao_inicio() {
+    journal_em_transacao++;
+}
+
+void pers_jrn_transacao_fim() {
+    if (journal_em_transacao == 0) return;
+    if (--journal_em_transacao > 0 || !journal_t_gravado) return;
+    journal_t_gravado = 0;
+    jrn_registrar("T}");
+}
+
+void pers_jrn_catalogo_add(const IngredienteBase* it) {
+    if (it) jrn_registrar_textos("C+", it->id, it->nome, it->unidade);
+}
+
+void pers_jrn_catalogo_del(int id) {
+    jrn_registrar("C-;%d", id);
+}
+
+void pers_jrn_estoque(const Estoque* estoque, int id_ingrediente) {
+    int idx = est_buscar_indice(estoque, id_ingrediente);
+    if (idx == -1) jrn_registrar("E-;%d", id_ingrediente);
+    else {
+        char txt[QTD_TEXTO_MAX];
+        jrn_registrar("E=;%d;%s", id_ingrediente, qtd_formatar(estoque->itens[idx].quantidade, txt, sizeof(txt)));
+    }
+}
+
+void pers_jrn_receita_add(const Receita* r) {
+    if (r) jrn_registrar_textos("R+", r->id, r->nome, r->modo_preparo);
+}
+
+void pers_jrn_receita_del(int id) {
+    jrn_registrar("R-;%d", id);
+}
+
+void pers_jrn_receita_ing(int id_receita, int id_ingrediente, Quantidade qtd) {
+    char txt[QTD_TEXTO_MAX];
+    jrn_registrar("I=;%d;%d;%s", id_receita, id_ingrediente, qtd_formatar(qtd, txt, sizeof(txt)));
+}
+
+void pers_jrn_receita_ing_del(int id_receita, int id_ingrediente) {
+    jrn_registrar("I-;%d;%d", id_receita, id_ingrediente);
+}
+
+void pers_jrn_pedido_add(const NoPedido* p) {
+    if (p) jrn_registrar("P+;%d;%d;%d", p->id_pedido, p->id_receita, p->prioridade);
+}
+
+void pers_jrn_pedido_del(int id_pedido) {
+    jrn_registrar("P-;%d", id_pedido);
+}
+
+/* 
+    separar_campos
+        - Divide a linha em campos nos ';' sem escape e desfaz os escapes
+          no lugar (o texto só encolhe). Campos vazios são mantidos.
+        - Retorna quantos campos havia, ou 0 se passou de 'max': um
+          registro com campos a mais está corrompido e é ignorado.
+ */
+static int separar_campos(char* linha, char** campos, int max) {
+    int n = 0;
+    char* w = linha;
+    campos[n++] = w;
+    for (char* r = linha; *r; r++) {
+        if (*r == '\\' && r[1]) {
+            r++;
+            *w++ = *r == 'n' ? '\n' : *r == 'r' ? '\r' : *r;
+        } else if (*r == ';') {
+            *w++ = '\0';
+            if (n == max) return 0;
+            campos[n++] = w;
+        } else {
+            *w++ = *r;
+        }
+    }
+    *w = '\0';
+    return n;
+}
+
+/* Campo i como inteiro: 1 se ele existe e é um número inteiro válido */
+static int campo_int(char** campos, int n, int i, int* out) {
+    return i < n && lei_int(campos[i], out);
+}
+
+/* Aplica um registro do journal. Retorna 1 se o registro era válido */
+static int aplicar_registro(char* linha, CatalogoIngredientes* cat, BancoReceitas* banco,
+                            Estoque* estoque, FilaPedidos* fila) {
+    char* c[4];
+    int n = separar_campos(linha, c, 4);
+    int id, id2, prio = PED_PRIO_NORMAL;
+    if (!campo_int(c, n, 1, &id)) return 0;
+    Quantidade qtd;
+
+    if (!strcmp(c[0], "C+") && n == 4) {
+        if (cat_buscar_id(cat, id)) cat_editar(cat, id, c[2], c[3]);
+        else cat_cadastrar_com_id(cat, id, c[2], c[3]);
+    } else if (!strcmp(c[0], "C-")) {
+        cat_remover(cat, id);
+    } else if (!strcmp(c[0], "E=") && n >= 3 && qtd_ler(c[2], &qtd)) {
+        est_definir(estoque, id, qtd);
+    } else if (!strcmp(c[0], "E-")) {
+        est_deletar_item(estoque, id);
+    } else if (!strcmp(c[0], "R+") && n == 4) {
+        if (rec_buscar_id(banco, id)) {
+            rec_editar_nome(banco, id, c[2]);
+            rec_editar_preparo(banco, id, c[3]);
+        } else {
+            rec_cadastrar_com_id(banco, id, c[2], c[3]);
+        }
+    } else if (!strcmp(c[0], "R-")) {
+        rec_remover(banco, id);
+    } else if (!strcmp(c[0], "I=") && n == 4 && campo_int(c, n, 2, &id2) && qtd_ler(c[3], &qtd)) {
+        rec_add_ingrediente(banco, id, id2, qtd);
+    } else if (!strcmp(c[0], "I-") && campo_int(c, n, 2, &id2)) {
+        rec_rem_ingrediente(banco, id, id2);
+    } else if (!strcmp(c[0], "P+") && campo_int(c, n, 2, &id2) && (n < 4 || campo_int(c, n, 3, &prio))) {
+        Receita* r = rec_buscar_id(banco, id2);
+        if (r && !ped_buscar(fila, id)) ped_adicionar_com_id(fila, id, r, prio);
+    } else if (!strcmp(c[0], "P-")) {
+        ped_remover(fila, id);
+    } else {
+        return 0;
+    }
+    return 1;
+}
+
+int pers_journal_reaplicar(CatalogoIngredientes* cat, BancoReceitas* banco,
+                           Estoque* estoque, FilaPedidos* fila) {
+    if (!cat || !banco || !estoque || !fila) return 0;
+    LeitorLinhas l;
+    if (!lei_abrir(&l, PATH_JOURNAL)) return 0;
+
+    char* linha;
+    char** pendentes = NULL;   /* registros da transação aberta */
+    int qtd_pend = 0, cap_pend = 0;
+    ArenaStrings texto_pend;   /* cópias dos registros pendentes, esvaziada a cada transação */
+    arena_iniciar(&texto_pend);
+    int em_transacao = 0;
+    journal_registros = 0;
+
+    while ((linha = lei_proxima(&l, NULL))) {
+        journal_registros++;
+        if (l.sem_quebra) break; /* última linha cortada por queda */
+
+        if (!strcmp(linha, "T{")) {
+            /* "T{" dentro de transação: a anterior nunca fechou, descarta */
+            arena_limpar(&texto_pend);
+            qtd_pend = 0;
+            em_transacao = 1;
+        } else if (!strcmp(linha, "T}")) {
+            for (int i = 0; i < qtd_pend; i++)
+                aplicar_registro(pendentes[i], cat, banco, estoque, fila);
+            arena_limpar(&texto_pend);
+            qtd_pend = 0;
+            em_transacao = 0;
+        } else if (em_transacao) {
+            if (qtd_pend == cap_pend) {
+                int nova_cap = cap_pend ? cap_pend * 2 : 16;
+                char** novo = realloc(pendentes, sizeof(char*) * nova_cap);
+                if (!novo) break;
+                pendentes = novo;
+                cap_pend = nova_cap;
+            }
+            char* copia = arena_copiar(&texto_pend, linha);
+            if (copia) pendentes[qtd_pend++] = copia;
+        } else if (strlen(linha) > 0) {
+            aplicar_registro(linha, cat, banco, estoque, fila);
+        }
+    }
+
+    /* Transação sem "T}" no fim do arquivo: descartada */
+    arena_liberar(&texto_pend);
+    free(pendentes);
+    lei_fechar(&l);
+    return (int)journal_registros;
+}
@@ -10,6 +10,12 @@
 #define PATH_RECEITAS     "data/receitas.txt"
 #define PATH_ESTOQUE      "data/estoque.txt"
 #define PATH_PEDIDOS      "data/pedidos.txt"
+#define PATH_JOURNAL      "data/journal.log"
+#define PATH_SNAPSHOT_BIN "data/snapshot.bin"
+
+/* Compacta (snapshot + journal vazio) ao passar de qualquer um dos limites */
+#define JOURNAL_LIMITE_REGISTROS 2000
+#define JOURNAL_LIMITE_BYTES     (1024L * 1024L)
 
 int pers_salvar_catalogo(const CatalogoIngredientes* cat);
 int pers_carregar_catalogo(CatalogoIngredientes* cat);
@@ -23,4 +29,63 @@ int pers_carregar_estoque(Estoque* estoque);
 int pers_salvar_pedidos(const FilaPedidos* fila);
 int pers_carregar_pedidos(FilaPedidos* fila, BancoReceitas* banco);
 
+// Os quatro *.txt: catalogo, receitas e estoque em paralelo (threads; em
+// serie no Windows), depois os pedidos. Retorna o de pers_carregar_catalogo
+int pers_carregar_texto(CatalogoIngredientes* cat, BancoReceitas* banco,
+                        Estoque* estoque, FilaPedidos* fila);
+
+/* 
+ * --- SNAPSHOT BINARIO (persistencia_bin.c) ---
+ * Registros de largura fixa + blob de strings, lido via mmap.
+ * Se PATH_SNAPSHOT_BIN existe, ele tem prioridade sobre os *.txt na
+ * carga e e regravado a cada compactacao para nunca ficar defasado.
+ */
+int pers_exportar_binario(const char* path, const CatalogoIngredientes* cat, const BancoReceitas* banco,
+                          const Estoque* estoque, const FilaPedidos* fila);
+// Carrega em colecoes vazias. Retorna 1 sucesso, 0 se ausente ou invalido
+int pers_carregar_binario(const char* path, CatalogoIngredientes* cat, BancoReceitas* banco,
+                          Estoque* estoque, FilaPedidos* fila);
+
+// Carga completa: snapshot binario (ou os *.txt) + journal.
+// Retorna quantas linhas o journal tinha, como pers_journal_reaplicar
+int pers_carregar_tudo(CatalogoIngredientes* cat, BancoReceitas* banco,
+                       Estoque* estoque, FilaPedidos* fila);
+
+/* 
+ * --- JOURNAL (write-ahead log) ---
+ * Cada mutacao vira um registro curto anexado em PATH_JOURNAL, em vez de
+ * reescrever o arquivo inteiro da colecao. Os registros guardam o estado
+ * final (ex: quantidade absoluta), entao reaplicar duas vezes e inofensivo.
+ * Na inicializacao: carrega os snapshots (*.txt) e reaplica o journal.
+ */
+
+// Reaplica o journal sobre os dados carregados. Retorna quantas linhas o
+// journal tinha (> 0: convem compactar logo, deixando o arquivo limpo)
+int pers_journal_reaplicar(CatalogoIngredientes* cat, BancoReceitas* banco,
+                           Estoque* estoque, FilaPedidos* fila);
+int pers_journal_abrir();
+void pers_journal_fechar();
+
+// 1 se o journal passou de JOURNAL_LIMITE_REGISTROS ou JOURNAL_LIMITE_BYTES
+int pers_journal_precisa_compactar();
+
+// Grava os quatro snapshots e esvazia o journal. Retorna 1 sucesso, 0 falha
+int pers_compactar(const CatalogoIngredientes* cat, const BancoReceitas* banco,
+                   const Estoque* estoque, const FilaPedidos* fila);
+
+// Registros que formam uma unica operacao (ex: processar pedido) ficam
+// entre inicio/fim de transacao: se o processo cair no meio, sao ignorados
+void pers_jrn_transacao_inicio();
+void pers_jrn_transacao_fim();
+
+void pers_jrn_catalogo_add(const IngredienteBase* it);
+void pers_jrn_catalogo_del(int id);
+void pers_jrn_estoque(const Estoque* estoque, int id_ingrediente); // valor atual ou remocao
+void pers_jrn_receita_add(const Receita* r);
+void pers_jrn_receita_del(int id);
+void pers_jrn_receita_ing(int id_receita, int id_ingrediente, Quantidade qtd);
+void pers_jrn_receita_ing_del(int id_receita, int id_ingrediente);
+void pers_jrn_pedido_add(const NoPedido* p);
+void pers_jrn_pedido_del(int id_pedido);
+
 #endif
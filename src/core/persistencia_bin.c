@@ -0,0 +1,323 @@
+/* mmap/open/fstat ficam escondidos com -std=c99 sem este define */
+#define _POSIX_C_SOURCE 200809L
+
+#include "persistencia.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+/*
+ * Snapshot binário (PATH_SNAPSHOT_BIN)
+ *
+ *   [BinCabecalho]
+ *   [BinCatalogo   x qtd_catalogo]
+ *   [BinEstoque    x qtd_estoque]
+ *   [BinReceita    x qtd_receitas]
+ *   [BinIngrediente x qtd_ingredientes]   (todas as receitas, em sequência)
+ *   [BinPedido     x qtd_pedidos]
+ *   [blob de strings terminadas em '\0']
+ *
+ * Todos os registros têm largura fixa (múltiplos de 4 bytes) e as strings
+ * são offsets dentro do blob: carregar é só aritmética de ponteiros sobre
+ * o arquivo mapeado em memória, sem tokenizar texto.
+ */
+
+#define BIN_MAGICO 0x4E42435Au  /* "ZCBN" em little-endian */
+#define BIN_VERSAO 3u    /* 2: BinPedido ganhou a prioridade; 3: quantidades em milesimos
+                            (arquivo de versao anterior cai na carga por texto) */
+
+typedef struct {
+    uint32_t magico;
+    uint32_t versao;
+    uint32_t qtd_catalogo;
+    uint32_t qtd_estoque;
+    uint32_t qtd_receitas;
+    uint32_t qtd_ingredientes;
+    uint32_t qtd_pedidos;
+    uint32_t tam_strings;
+    int32_t  prox_id_catalogo;
+    int32_t  prox_id_receita;
+    int32_t  prox_id_pedido;
+    uint32_t reservado;
+} BinCabecalho;
+
+typedef struct { int32_t id; uint32_t nome; uint32_t unidade; } BinCatalogo;
+/* Quantidade em milesimos (64 bits) partida em duas metades de 32, para os
+   registros continuarem alinhados a 4 bytes dentro do arquivo */
+typedef struct { int32_t alta; uint32_t baixa; } BinQuantidade;
+
+typedef struct { int32_t id; BinQuantidade quantidade; } BinEstoque;
+typedef struct { int32_t id; uint32_t nome; uint32_t preparo; uint32_t prim_ing; uint32_t qtd_ing; } BinReceita;
+typedef struct { int32_t id; BinQuantidade quantidade; } BinIngrediente;
+typedef struct { int32_t id_pedido; int32_t id_receita; int32_t prioridade; } BinPedido;
+
+static BinQuantidade qtd_para_bin(Quantidade q) {
+    BinQuantidade b;
+    b.alta = (int32_t)(q >> 32);
+    b.baixa = (uint32_t)((unsigned long long)q & 0xFFFFFFFFu);
+    return b;
+}
+
+/* O arquivo pode vir corrompido: o valor volta para +-QTD_MAXIMO, a faixa
+   que estoque e receitas assumem (ver qtd_primeiro_insuficiente) */
+static Quantidade qtd_de_bin(BinQuantidade b) {
+    Quantidade q = (Quantidade)(((unsigned long long)(uint32_t)b.alta << 32) | b.baixa);
+    if (q > QTD_MAXIMO) return QTD_MAXIMO;
+    if (q < -QTD_MAXIMO) return -QTD_MAXIMO;
+    return q;
+}
+
+/* ─── Exportação ──────────────────────────────────────────────────────────── */
+
+/* Blob de strings em construção */
+typedef struct {
+    char* dados;
+    size_t tam;
+    size_t cap;
+} BlobStrings;
+
+/* Copia s para o blob e devolve o offset; UINT32_MAX em falha */
+static uint32_t blob_add(BlobStrings* b, const char* s) {
+    size_t len = strlen(s ? s : "") + 1;
+    if (b->tam + len > b->cap) {
+        size_t nova = b->cap ? b->cap * 2 : 4096;
+        while (nova < b->tam + len) nova *= 2;
+        char* novo = realloc(b->dados, nova);
+        if (!novo) return UINT32_MAX;
+        b->dados = novo;
+        b->cap = nova;
+    }
+    uint32_t off = (uint32_t)b->tam;
+    memcpy(b->dados + b->tam, s ? s : "", len);
+    b->tam += len;
+    return off;
+}
+
+static int gravar(FILE* f, const void* p, size_t tam, size_t n) {
+    return n == 0 || fwrite(p, tam, n, f) == n;
+}
+
+int pers_exportar_binario(const char* path, const CatalogoIngredientes* cat, const BancoReceitas* banco,
+                          const Estoque* estoque, const FilaPedidos* fila) {
+    if (!path || !cat || !banco || !estoque || !fila) return 0;
+
+    BinCabecalho cab;
+    memset(&cab, 0, sizeof(cab));
+    cab.magico = BIN_MAGICO;
+    cab.versao = BIN_VERSAO;
+    cab.qtd_catalogo = (uint32_t)cat->qtd_atual;
+    cab.qtd_estoque = (uint32_t)estoque->qtd_atual;
+    cab.qtd_receitas = (uint32_t)banco->qtd_atual;
+    cab.prox_id_catalogo = cat->prox_id;
+    cab.prox_id_receita = banco->prox_id;
+    cab.prox_id_pedido = fila->prox_id;
+
+    for (int i = 0; i < banco->qtd_slots; i++)
+        if (banco->vetor[i]) cab.qtd_ingredientes += (uint32_t)banco->vetor[i]->ingredientes.qtd;
+    for (NoPedido* p = fila->inicio; p; p = p->prox)
+        if (ped_receita(fila, p)) cab.qtd_pedidos++;
+
+    BinCatalogo* bcat = malloc(sizeof(BinCatalogo) * (cab.qtd_catalogo + 1));
+    BinEstoque* best = malloc(sizeof(BinEstoque) * (cab.qtd_estoque + 1));
+    BinReceita* brec = malloc(sizeof(BinReceita) * (cab.qtd_receitas + 1));
+    BinIngrediente* bing = malloc(sizeof(BinIngrediente) * (cab.qtd_ingredientes + 1));
+    BinPedido* bped = malloc(sizeof(BinPedido) * (cab.qtd_pedidos + 1));
+    BlobStrings blob = { NULL, 0, 0 };
+    int ok = bcat && best && brec && bing && bped;
+
+    /* n = proxima posicao no arquivo; as lapides dos arrays nao sao gravadas */
+    uint32_t n = 0;
+    for (size_t i = 0; ok && i < cat->qtd_slots; i++) {
+        const IngredienteBase* it = &cat->itens[i];
+        if (it->id == 0) continue;
+        bcat[n].id = it->id;
+        bcat[n].nome = blob_add(&blob, it->nome);
+        bcat[n].unidade = blob_add(&blob, it->unidade);
+        ok = bcat[n].nome != UINT32_MAX && bcat[n].unidade != UINT32_MAX;
+        n++;
+    }
+    n = 0;
+    for (int i = 0; ok && i < estoque->qtd_slots; i++) {
+        if (estoque->itens[i].id_ingrediente < 0) continue;
+        best[n].id = estoque->itens[i].id_ingrediente;
+        best[n].quantidade = qtd_para_bin(estoque->itens[i].quantidade);
+        n++;
+    }
+    uint32_t k = 0;
+    n = 0;
+    for (int i = 0; ok && i < banco->qtd_slots; i++) {
+        Receita* r = banco->vetor[i];
+        if (!r) continue;
+        brec[n].id = r->id;
+        brec[n].nome = blob_add(&blob, r->nome);
+        brec[n].preparo = blob_add(&blob, r->modo_preparo);
+        brec[n].prim_ing = k;
+        for (int j = 0; j < r->ingredientes.qtd; j++) {
+            bing[k].id = r->ingredientes.itens[j].id_ingrediente;
+            bing[k].quantidade = qtd_para_bin(r->ingredientes.itens[j].quantidade);
+            k++;
+        }
+        brec[n].qtd_ing = k - brec[n].prim_ing;
+        ok = brec[n].nome != UINT32_MAX && brec[n].preparo != UINT32_MAX;
+        n++;
+    }
+    k = 0;
+    for (NoPedido* p = fila->inicio; ok && p; p = p->prox) {
+        if (!ped_receita(fila, p)) continue;
+        bped[k].id_pedido = p->id_pedido;
+        bped[k].id_receita = p->id_receita;
+        bped[k].prioridade = p->prioridade;
+        k++;
+    }
+    cab.tam_strings = (uint32_t)blob.tam;
+
+    char tmp[256];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+    FILE* f = ok ? fopen(tmp, "wb") : NULL;
+    if (f) {
+        ok = gravar(f, &cab, sizeof(cab), 1)
+          && gravar(f, bcat, sizeof(BinCatalogo), cab.qtd_catalogo)
+          && gravar(f, best, sizeof(BinEstoque), cab.qtd_estoque)
+          && gravar(f, brec, sizeof(BinReceita), cab.qtd_receitas)
+          && gravar(f, bing, sizeof(BinIngrediente), cab.qtd_ingredientes)
+          && gravar(f, bped, sizeof(BinPedido), cab.qtd_pedidos)
+          && gravar(f, blob.dados, 1, blob.tam);
+        if (fclose(f) != 0) ok = 0;
+#ifdef _WIN32
+        if (ok) remove(path);
+#endif
+        if (ok) ok = rename(tmp, path) == 0;
+        if (!ok) remove(tmp);
+    } else {
+        ok = 0;
+    }
+
+    free(bcat);
+    free(best);
+    free(brec);
+    free(bing);
+    free(bped);
+    free(blob.dados);
+    return ok;
+}
+
+/* ─── Carga ───────────────────────────────────────────────────────────────── */
+
+/*
+    mapear_arquivo
+        - POSIX: mmap somente leitura (páginas carregadas sob demanda).
+        - Windows: lê o arquivo inteiro para um buffer.
+ */
+static const unsigned char* mapear_arquivo(const char* path, size_t* tam) {
+#ifndef _WIN32
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return NULL;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        close(fd);
+        return NULL;
+    }
+    void* p = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) return NULL;
+    *tam = (size_t)st.st_size;
+    return p;
+#else
+    FILE* f = fopen(path, "rb");
+    if (!f) return NULL;
+    fseek(f, 0, SEEK_END);
+    long n = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    unsigned char* buf = n > 0 ? malloc((size_t)n) : NULL;
+    if (buf && fread(buf, 1, (size_t)n, f) != (size_t)n) {
+        free(buf);
+        buf = NULL;
+    }
+    fclose(f);
+    if (buf) *tam = (size_t)n;
+    return buf;
+#endif
+}
+
+static void desmapear_arquivo(const unsigned char* p, size_t tam) {
+#ifndef _WIN32
+    munmap((void*)p, tam);
+#else
+    (void)tam;
+    free((void*)p);
+#endif
+}
+
+int pers_carregar_binario(const char* path, CatalogoIngredientes* cat, BancoReceitas* banco,
+                          Estoque* estoque, FilaPedidos* fila) {
+    if (!path || !cat || !banco || !estoque || !fila) return 0;
+    size_t tam = 0;
+    const unsigned char* base = mapear_arquivo(path, &tam);
+    if (!base) return 0;
+
+    const BinCabecalho* cab = (const BinCabecalho*)base;
+    int ok = tam >= sizeof(BinCabecalho) && cab->magico == BIN_MAGICO && cab->versao == BIN_VERSAO;
+
+    /* Tamanho esperado: cabeçalho + registros + blob, tudo em 64 bits */
+    unsigned long long esperado = 0;
+    if (ok) {
+        esperado = sizeof(BinCabecalho)
+                 + (unsigned long long)cab->qtd_catalogo * sizeof(BinCatalogo)
+                 + (unsigned long long)cab->qtd_estoque * sizeof(BinEstoque)
+                 + (unsigned long long)cab->qtd_receitas * sizeof(BinReceita)
+                 + (unsigned long long)cab->qtd_ingredientes * sizeof(BinIngrediente)
+                 + (unsigned long long)cab->qtd_pedidos * sizeof(BinPedido)
+                 + cab->tam_strings;
+        ok = esperado == tam && (cab->tam_strings == 0 || base[tam - 1] == '\0');
+    }
+    if (!ok) {
+        desmapear_arquivo(base, tam);
+        return 0;
+    }
+
+    const BinCatalogo* bcat = (const BinCatalogo*)(cab + 1);
+    const BinEstoque* best = (const BinEstoque*)(bcat + cab->qtd_catalogo);
+    const BinReceita* brec = (const BinReceita*)(best + cab->qtd_estoque);
+    const BinIngrediente* bing = (const BinIngrediente*)(brec + cab->qtd_receitas);
+    const BinPedido* bped = (const BinPedido*)(bing + cab->qtd_ingredientes);
+    const char* strings = (const char*)(bped + cab->qtd_pedidos);
+    uint32_t ts = cab->tam_strings;
+
+    for (uint32_t i = 0; i < cab->qtd_catalogo; i++) {
+        if (bcat[i].nome >= ts || bcat[i].unidade >= ts) continue;
+        cat_cadastrar_com_id(cat, bcat[i].id, strings + bcat[i].nome, strings + bcat[i].unidade);
+    }
+    for (uint32_t i = 0; i < cab->qtd_estoque; i++) {
+        est_adicionar(estoque, best[i].id, qtd_de_bin(best[i].quantidade));
+    }
+    for (uint32_t i = 0; i < cab->qtd_receitas; i++) {
+        const BinReceita* br = &brec[i];
+        if (br->nome >= ts || br->preparo >= ts) continue;
+        if (br->prim_ing > cab->qtd_ingredientes || br->qtd_ing > cab->qtd_ingredientes - br->prim_ing) continue;
+        int id = rec_cadastrar_com_id(banco, br->id, strings + br->nome, strings + br->preparo);
+        /* Gravados em ordem de id: cada inserção cai no fim do vetor */
+        for (uint32_t j = 0; id && j < br->qtd_ing; j++) {
+            const BinIngrediente* bi = &bing[br->prim_ing + j];
+            rec_add_ingrediente(banco, id, bi->id, qtd_de_bin(bi->quantidade));
+        }
+    }
+    for (uint32_t i = 0; i < cab->qtd_pedidos; i++) {
+        Receita* r = rec_buscar_id(banco, bped[i].id_receita);
+        if (r) ped_adicionar_com_id(fila, bped[i].id_pedido, r, bped[i].prioridade);
+    }
+
+    if (cab->prox_id_catalogo > cat->prox_id) cat->prox_id = cab->prox_id_catalogo;
+    if (cab->prox_id_receita > banco->prox_id) banco->prox_id = cab->prox_id_receita;
+    if (cab->prox_id_pedido > fila->prox_id) fila->prox_id = cab->prox_id_pedido;
+
+    desmapear_arquivo(base, tam);
+    return 1;
+}
@@ -0,0 +1,76 @@
+#include "pool.h"
+#include <stdlib.h>
+
+/* Cabecalho de cada slab; a uniao garante alinhamento para os objetos logo depois dele */
+typedef union CabecalhoSlab {
+    union CabecalhoSlab* prox;
+    double d;
+    long long ll;
+    void* p;
+} CabecalhoSlab;
+
+#define ALINHAMENTO sizeof(CabecalhoSlab)
+
+void pool_iniciar(PoolFixo* pool, const char* nome, size_t tam_obj) {
+    if (!pool) return;
+    if (tam_obj < sizeof(void*)) tam_obj = sizeof(void*);
+    pool->nome = nome;
+    pool->tam_obj = (tam_obj + ALINHAMENTO - 1) / ALINHAMENTO * ALINHAMENTO;
+    pool->slabs = NULL;
+    pool->livres = NULL;
+    pool->proximo_virgem = 0;
+    pool->stats = (PoolStats){0, 0, 0, 0, 0, 0};
+}
+
+void pool_liberar(PoolFixo* pool) {
+    if (!pool) return;
+    CabecalhoSlab* s = pool->slabs;
+    while (s) {
+        CabecalhoSlab* prox = s->prox;
+        free(s);
+        s = prox;
+    }
+    pool->slabs = NULL;
+    pool->livres = NULL;
+    pool->proximo_virgem = 0;
+    pool->stats.em_uso = 0;
+}
+
+/*
+    pool_alocar
+        - Ordem: lista de livres, depois o resto ainda nunca usado do slab
+          mais novo, e so entao um slab novo. O slab novo nao e
+          "fatiado" na lista de livres: os objetos saem dele em sequencia.
+ */
+void* pool_alocar(PoolFixo* pool) {
+    if (!pool) return NULL;
+    void* obj;
+    if (pool->livres) {
+        obj = pool->livres;
+        pool->livres = *(void**)obj;
+        pool->stats.reaproveitados++;
+    } else {
+        if (pool->proximo_virgem == 0) {
+            CabecalhoSlab* s = malloc(sizeof(CabecalhoSlab) + pool->tam_obj * POOL_OBJS_POR_SLAB);
+            if (!s) return NULL;
+            s->prox = pool->slabs;
+            pool->slabs = s;
+            pool->proximo_virgem = POOL_OBJS_POR_SLAB;
+            pool->stats.slabs++;
+        }
+        char* base = (char*)((CabecalhoSlab*)pool->slabs + 1);
+        obj = base + pool->tam_obj * (POOL_OBJS_POR_SLAB - pool->proximo_virgem);
+        pool->proximo_virgem--;
+    }
+    pool->stats.alocacoes++;
+    if (++pool->stats.em_uso > pool->stats.pico) pool->stats.pico = pool->stats.em_uso;
+    return obj;
+}
+
+void pool_devolver(PoolFixo* pool, void* obj) {
+    if (!pool || !obj) return;
+    *(void**)obj = pool->livres;
+    pool->livres = obj;
+    pool->stats.em_uso--;
+    pool->stats.devolucoes++;
+}
@@ -0,0 +1,45 @@
+#ifndef POOL_H
+#define POOL_H
+
+#include <stddef.h>
+
+/*
+ * Pool de objetos de tamanho fixo (slab + lista de livres).
+ *
+ * A memoria vem em blocos (slabs) de POOL_OBJS_POR_SLAB objetos; um objeto
+ * devolvido vai para a lista de livres e e o primeiro a ser reaproveitado.
+ * Os slabs so voltam ao sistema em pool_liberar, de uma vez.
+ *
+ * Os modulos que usam pool aceitam um ponteiro NULL ("sem pool") e caem
+ * em malloc/free, para estruturas criadas fora de um AppContext.
+ */
+
+#define POOL_OBJS_POR_SLAB 64
+
+typedef struct {
+    size_t slabs;           // blocos pedidos ao malloc
+    size_t em_uso;          // objetos entregues e ainda nao devolvidos
+    size_t pico;            // maior em_uso ja visto
+    size_t alocacoes;       // total de pool_alocar atendidos
+    size_t reaproveitados;  // ... dos quais vieram da lista de livres
+    size_t devolucoes;      // total de pool_devolver
+} PoolStats;
+
+typedef struct {
+    const char* nome;
+    size_t tam_obj;         // arredondado para caber o ponteiro da lista de livres
+    void* slabs;            // lista encadeada dos blocos
+    void* livres;           // lista de livres (o "prox" mora dentro do objeto)
+    size_t proximo_virgem;  // objetos ainda nunca usados no slab mais novo
+    PoolStats stats;
+} PoolFixo;
+
+void pool_iniciar(PoolFixo* pool, const char* nome, size_t tam_obj);
+// Devolve tudo ao sistema (os objetos ainda em uso ficam invalidos)
+void pool_liberar(PoolFixo* pool);
+
+// Um objeto de tam_obj bytes (conteudo indefinido) ou NULL
+void* pool_alocar(PoolFixo* pool);
+void pool_devolver(PoolFixo* pool, void* obj);
+
+#endif
@@ -0,0 +1,73 @@
+#include "producao.h"
+#include <stdlib.h>
+#include <limits.h>
+
+CacheProducao *prd_criar(const BancoReceitas *banco, Estoque *estoque) {
+    CacheProducao *c = calloc(1, sizeof(CacheProducao));
+    if (!c) return NULL;
+    c->banco = banco;
+    c->estoque = estoque;
+    c->versao_banco = banco->versao;
+    if (!hsh_inicializar(&c->porcoes_por_receita, 16)) {
+        free(c);
+        return NULL;
+    }
+    if (!est_observar(estoque, prd_ingrediente_mudou, c)) {
+        prd_liberar(c);
+        return NULL;
+    }
+    return c;
+}
+
+void prd_liberar(CacheProducao *c) {
+    if (!c) return;
+    hsh_liberar(&c->porcoes_por_receita);
+    free(c);
+}
+
+/*
+    calcular_porcoes
+        - Minimo de floor(disponivel / exigido) entre os ingredientes. Um
+          ingrediente fora do estoque zera o resultado; quantidades
+          exigidas <= 0 nao limitam. Em milesimos a divisao e exata
+          (0.3 / 0.1 da 3, sem folga para arredondamento).
+ */
+static int calcular_porcoes(const Estoque *est, const Receita *r) {
+    int minimo = INT_MAX;
+    for (int k = 0; k < r->ingredientes.qtd; k++) {
+        const IngredienteReceita *ing = &r->ingredientes.itens[k];
+        if (ing->quantidade <= 0) continue;
+        int idx = est_buscar_indice(est, ing->id_ingrediente);
+        if (idx == -1) return 0;
+        const ItemEstoque *it = &est->itens[idx];
+        Quantidade disponivel = it->quantidade - it->reservado;
+        Quantidade razao = disponivel <= 0 ? 0 : disponivel / ing->quantidade;
+        int n = razao >= INT_MAX ? INT_MAX : (int)razao;
+        if (n < minimo) minimo = n;
+    }
+    return minimo == INT_MAX ? 0 : minimo;
+}
+
+int prd_porcoes(CacheProducao *c, int id_receita) {
+    if (!c) return -1;
+    if (c->versao_banco != c->banco->versao) {
+        hsh_limpar(&c->porcoes_por_receita);
+        c->versao_banco = c->banco->versao;
+    }
+    int porcoes = hsh_buscar(&c->porcoes_por_receita, id_receita);
+    if (porcoes >= 0) return porcoes;
+
+    const Receita *r = rec_buscar_id(c->banco, id_receita);
+    if (!r) return -1;
+    porcoes = calcular_porcoes(c->estoque, r);
+    hsh_inserir(&c->porcoes_por_receita, id_receita, porcoes); // sem memoria: so nao fica em cache
+    return porcoes;
+}
+
+void prd_ingrediente_mudou(void *ctx, int id_ingrediente) {
+    CacheProducao *c = ctx;
+    if (!c) return;
+    const int *ids;
+    int n = rec_receitas_com(c->banco, id_ingrediente, &ids);
+    for (int k = 0; k < n; k++) hsh_remover(&c->porcoes_por_receita, ids[k]);
+}
@@ -0,0 +1,43 @@
+#ifndef PRODUCAO_H
+#define PRODUCAO_H
+
+#include <stddef.h>
+#include "hash.h"
+#include "estoque.h"
+#include "receitas.h"
+
+/*
+ * Cache de "quantas porcoes da receita X da para fazer agora":
+ *     min sobre os ingredientes de (estoque / quantidade exigida)
+ *
+ * O valor de cada receita fica guardado ate que o estoque de um dos seus
+ * ingredientes mude; o aviso vem do observador do Estoque (est_observar),
+ * que descarta so as receitas que usam aquele ingrediente, pelo indice
+ * invertido do proprio banco (rec_receitas_com).
+ *
+ * Quando o banco de receitas muda (BancoReceitas.versao) o cache e
+ * esvaziado na proxima consulta e os valores sao recalculados sob demanda.
+ *
+ * Como o aviso do estoque le o banco, estoque e banco nao podem mudar ao
+ * mesmo tempo em threads diferentes: a carga paralela (pers_carregar_texto)
+ * suspende os avisos do estoque ate as receitas terminarem
+ * (est_suspender_avisos / est_retomar_avisos).
+ */
+typedef struct {
+    const BancoReceitas *banco;
+    const Estoque *estoque;
+    unsigned long versao_banco;     // versao do banco dos valores guardados
+    IndiceHash porcoes_por_receita; // id_receita -> porcoes (ausente = recalcular)
+} CacheProducao;
+
+// Cria o cache e se registra como observador do estoque
+CacheProducao *prd_criar(const BancoReceitas *banco, Estoque *estoque);
+void prd_liberar(CacheProducao *c);
+
+// Porcoes produziveis da receita, ou -1 se ela nao existe
+int prd_porcoes(CacheProducao *c, int id_receita);
+
+// Observador do estoque: invalida as receitas que usam o ingrediente
+void prd_ingrediente_mudou(void *ctx, int id_ingrediente);
+
+#endif
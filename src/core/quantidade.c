@@ -0,0 +1,106 @@
+#include "quantidade.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <ctype.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/*
+    qtd_ler
+        - Parte inteira e ate 3 casas lidas como inteiros; a 4a casa decide
+          o arredondamento (metade para longe do zero). Casas alem disso
+          sao ignoradas.
+        - Aceita espacos antes, sinal e lixo depois do numero (como o atof
+          que existia antes). Notacao com expoente ("1e3") cai no strtod.
+        - Falha sem digitos ou com modulo acima de QTD_MAXIMO.
+ */
+int qtd_ler(const char* texto, Quantidade* out) {
+    if (!texto || !out) return 0;
+    const char* p = texto;
+    while (isspace((unsigned char)*p)) p++;
+
+    int negativo = 0;
+    if (*p == '-' || *p == '+') negativo = (*p++ == '-');
+
+    long long inteiro = 0, fracao = 0;
+    int digitos = 0, casas = 0, arredondar = 0;
+    for (; isdigit((unsigned char)*p); p++, digitos++) {
+        inteiro = inteiro * 10 + (*p - '0');
+        if (inteiro > QTD_MAXIMO / QTD_ESCALA) return 0;
+    }
+    if (*p == '.') {
+        for (p++; isdigit((unsigned char)*p); p++, digitos++) {
+            if (casas < 3) { fracao = fracao * 10 + (*p - '0'); casas++; }
+            else if (casas++ == 3) arredondar = (*p >= '5');
+        }
+    }
+    if (digitos == 0) return 0;
+
+    if (*p == 'e' || *p == 'E') {
+        char* fim;
+        double v = strtod(texto, &fim);
+        if (fim != p) { /* "1e" sem expoente: vale so a parte lida antes */
+            if (!(v < (double)QTD_MAXIMO / QTD_ESCALA && v > -(double)QTD_MAXIMO / QTD_ESCALA)) return 0;
+            *out = qtd_de_unidades(v);
+            return 1;
+        }
+    }
+
+    for (; casas < 3; casas++) fracao *= 10;
+    Quantidade q = inteiro * QTD_ESCALA + fracao + arredondar;
+    if (q > QTD_MAXIMO) return 0;
+    *out = negativo ? -q : q;
+    return 1;
+}
+
+int qtd_casas(Quantidade q) {
+    return q % 10 ? 3 : 2;
+}
+
+const char* qtd_formatar(Quantidade q, char* buf, size_t tam) {
+    if (!buf || tam == 0) return buf;
+    unsigned long long m = q < 0 ? 0ULL - (unsigned long long)q : (unsigned long long)q;
+    unsigned long long frac = m % QTD_ESCALA;
+    if (qtd_casas(q) == 3)
+        snprintf(buf, tam, "%s%llu.%03llu", q < 0 ? "-" : "", m / QTD_ESCALA, frac);
+    else
+        snprintf(buf, tam, "%s%llu.%02llu", q < 0 ? "-" : "", m / QTD_ESCALA, frac / 10);
+    return buf;
+}
+
+double qtd_em_unidades(Quantidade q) {
+    return (double)q / QTD_ESCALA;
+}
+
+Quantidade qtd_de_unidades(double v) {
+    double m = v * QTD_ESCALA;
+    if (m >= (double)QTD_MAXIMO) return QTD_MAXIMO;
+    if (m <= -(double)QTD_MAXIMO) return -QTD_MAXIMO;
+    return (Quantidade)(m < 0 ? m - 0.5 : m + 0.5);
+}
+
+/*
+    qtd_primeiro_insuficiente
+        - Com SSE2: subtrai dois pares de 64 bits de uma vez (tem - precisa)
+          e junta os bits de sinal com movemask; qualquer bit aceso marca um
+          par insuficiente. Nao ha comparacao de 64 bits com sinal no SSE2,
+          mas a subtracao basta porque os valores ficam dentro de
+          +-QTD_MAXIMO e a diferenca nao estoura.
+        - O resto (n impar ou sem SSE2) e comparado um a um.
+ */
+int qtd_primeiro_insuficiente(const Quantidade* tem, const Quantidade* precisa, int n) {
+    int i = 0;
+#ifdef __SSE2__
+    for (; i + 2 <= n; i += 2) {
+        __m128i a = _mm_loadu_si128((const __m128i*)(tem + i));
+        __m128i b = _mm_loadu_si128((const __m128i*)(precisa + i));
+        int sinais = _mm_movemask_pd(_mm_castsi128_pd(_mm_sub_epi64(a, b)));
+        if (sinais) return (sinais & 1) ? i : i + 1;
+    }
+#endif
+    for (; i < n; i++)
+        if (tem[i] < precisa[i]) return i;
+    return -1;
+}
@@ -0,0 +1,35 @@
+#ifndef QUANTIDADE_H
+#define QUANTIDADE_H
+
+#include <stddef.h>
+
+/*
+ * Quantidades em ponto fixo: inteiro de milesimos da unidade do catalogo
+ * (1.5 kg = 1500, 0.25 un = 250). Somar e subtrair e exato, entao ciclos
+ * de entrada/baixa no estoque nao acumulam erro e a conferencia
+ * "disponivel >= necessario" nao recusa um pedido por arredondamento.
+ *
+ * No texto (arquivos, journal, JSON) o valor vai com 2 casas, ou 3 quando
+ * o milesimo nao e zero, e volta do texto sem passar por float.
+ */
+typedef long long Quantidade;
+
+#define QTD_ESCALA  1000
+#define QTD_MAXIMO  1000000000000000LL   /* 10^12 unidades: folga para somar sem estourar */
+#define QTD_TEXTO_MAX 32
+
+// Le "12", "-0.5", "1.575" (mais de 3 casas: arredonda). 1 ok, 0 texto invalido
+int qtd_ler(const char* texto, Quantidade* out);
+// Escreve em buf (QTD_TEXTO_MAX bytes bastam) e retorna buf
+const char* qtd_formatar(Quantidade q, char* buf, size_t tam);
+// Casas decimais que qtd_formatar usa (2 ou 3), para o JSON
+int qtd_casas(Quantidade q);
+
+double qtd_em_unidades(Quantidade q);
+Quantidade qtd_de_unidades(double v); /* arredonda para o milesimo mais proximo */
+
+// Primeiro i com tem[i] < precisa[i], ou -1 se todos cabem.
+// Com SSE2 compara dois pares por instrucao.
+int qtd_primeiro_insuficiente(const Quantidade* tem, const Quantidade* precisa, int n);
+
+#endif
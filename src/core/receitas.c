@@ -7,106 +7,253 @@
 #define REC_INITIAL_CAPACITY 8
 
 /* Inicializa o banco de receitas (Array Dinamico de ponteiros) */
-BancoReceitas* rec_inicializar() {
+BancoReceitas* rec_inicializar(ArenaStrings* arena) {
     BancoReceitas* banco = (BancoReceitas*) malloc(sizeof(BancoReceitas));
     if (!banco) return NULL;
     
     banco->capacidade = REC_INITIAL_CAPACITY;
     banco->qtd_atual = 0;
+    banco->qtd_slots = 0;
+    banco->qtd_livres = 0;
     banco->prox_id = 1; // IDs gerados por prox_id 
+    banco->versao = 0;
+    banco->arena = arena;
     banco->vetor = (Receita**) malloc(sizeof(Receita*) * banco->capacidade);
-    
-    if (!banco->vetor) {
+    banco->geracoes = (unsigned*) malloc(sizeof(unsigned) * banco->capacidade);
+    banco->livres = (int*) malloc(sizeof(int) * banco->capacidade);
+
+    banco->usos = NULL;
+    banco->qtd_usos = 0;
+    banco->cap_usos = 0;
+    if (!banco->vetor || !banco->geracoes || !banco->livres ||
+        !hsh_inicializar(&banco->por_id, REC_INITIAL_CAPACITY)) {
+        free(banco->vetor);
+        free(banco->geracoes);
+        free(banco->livres);
+        free(banco);
+        return NULL;
+    }
+    if (!hsh_inicializar(&banco->uso_por_ingrediente, REC_INITIAL_CAPACITY)) {
+        hsh_liberar(&banco->por_id);
+        free(banco->vetor);
+        free(banco->geracoes);
+        free(banco->livres);
         free(banco);
         return NULL;
     }
     return banco;
 }
 
-/* Garante que o array tenha espaco, usando realloc se necessario */
+/* Garante espaco para um slot novo (vetor, geracoes e livres crescem juntos), usando realloc se necessario */
 static int ensure_capacity(BancoReceitas* banco) {
-    if (banco->qtd_atual < banco->capacidade) return 1;
+    if (banco->qtd_slots < banco->capacidade) return 1;
     int newcap = banco->capacidade * 2;
     Receita** newvetor = realloc(banco->vetor, sizeof(Receita*) * newcap);
     if (!newvetor) return 0;
     banco->vetor = newvetor;
+    unsigned* newger = realloc(banco->geracoes, sizeof(unsigned) * newcap);
+    if (!newger) return 0;
+    banco->geracoes = newger;
+    int* newlivres = realloc(banco->livres, sizeof(int) * newcap);
+    if (!newlivres) return 0;
+    banco->livres = newlivres;
     banco->capacidade = newcap;
     return 1;
 }
 
-/* Cadastrar: Cria uma nova receita e adiciona ao banco */
-int rec_cadastrar(BancoReceitas* banco, const char* nome, const char* preparo) {
-    if (!banco || !nome) return 0;
-    if (!ensure_capacity(banco)) return 0;
+/* Texto da receita: internado na arena (nunca liberado um a um) ou utl_strdup sem arena */
+static char* copiar_texto(const BancoReceitas* banco, const char* s) {
+    return banco->arena ? arena_internar(banco->arena, s) : utl_strdup(s);
+}
+
+static void soltar_texto(const BancoReceitas* banco, char* s) {
+    if (!banco->arena) free(s);
+}
+
+/* ─── Indice invertido ingrediente -> receitas ─── */
+
+/* Conjunto do ingrediente; cria a entrada se 'criar' e ela nao existe (NULL se falhar) */
+static UsoIngrediente* uso_do_ingrediente(BancoReceitas* banco, int id_ingrediente, int criar) {
+    int pos = hsh_buscar(&banco->uso_por_ingrediente, id_ingrediente);
+    if (pos != -1) return &banco->usos[pos];
+    if (!criar) return NULL;
+
+    if (banco->qtd_usos == banco->cap_usos) {
+        int novacap = banco->cap_usos ? banco->cap_usos * 2 : REC_INITIAL_CAPACITY;
+        UsoIngrediente* novo = realloc(banco->usos, sizeof(UsoIngrediente) * novacap);
+        if (!novo) return NULL;
+        banco->usos = novo;
+        banco->cap_usos = novacap;
+    }
+    if (!hsh_inserir(&banco->uso_por_ingrediente, id_ingrediente, banco->qtd_usos)) return NULL;
+    UsoIngrediente* u = &banco->usos[banco->qtd_usos++];
+    u->receitas = NULL;
+    u->qtd = 0;
+    u->capacidade = 0;
+    return u;
+}
+
+/* Posicao de id_receita no conjunto (ou onde ele entraria), busca binaria */
+static int posicao_uso(const UsoIngrediente* u, int id_receita) {
+    int ini = 0, fim = u->qtd;
+    while (ini < fim) {
+        int meio = ini + (fim - ini) / 2;
+        if (u->receitas[meio] < id_receita) ini = meio + 1;
+        else fim = meio;
+    }
+    return ini;
+}
+
+static int registrar_uso(BancoReceitas* banco, int id_ingrediente, int id_receita) {
+    UsoIngrediente* u = uso_do_ingrediente(banco, id_ingrediente, 1);
+    if (!u) return 0;
+    int pos = posicao_uso(u, id_receita);
+    if (pos < u->qtd && u->receitas[pos] == id_receita) return 1;
+    if (u->qtd == u->capacidade) {
+        int novacap = u->capacidade ? u->capacidade * 2 : 4;
+        int* novo = realloc(u->receitas, sizeof(int) * novacap);
+        if (!novo) return 0;
+        u->receitas = novo;
+        u->capacidade = novacap;
+    }
+    memmove(&u->receitas[pos + 1], &u->receitas[pos], sizeof(int) * (size_t)(u->qtd - pos));
+    u->receitas[pos] = id_receita;
+    u->qtd++;
+    return 1;
+}
+
+static void desregistrar_uso(BancoReceitas* banco, int id_ingrediente, int id_receita) {
+    UsoIngrediente* u = uso_do_ingrediente(banco, id_ingrediente, 0);
+    if (!u) return;
+    int pos = posicao_uso(u, id_receita);
+    if (pos == u->qtd || u->receitas[pos] != id_receita) return;
+    memmove(&u->receitas[pos], &u->receitas[pos + 1], sizeof(int) * (size_t)(u->qtd - pos - 1));
+    u->qtd--;
+}
+
+int rec_receitas_com(const BancoReceitas* banco, int id_ingrediente, const int** ids) {
+    *ids = NULL;
+    if (!banco) return 0;
+    int pos = hsh_buscar(&banco->uso_por_ingrediente, id_ingrediente);
+    if (pos == -1) return 0;
+    *ids = banco->usos[pos].receitas;
+    return banco->usos[pos].qtd;
+}
+
+int rec_ingrediente_em_uso(const BancoReceitas* banco, int id_ingrediente) {
+    const int* ids;
+    return rec_receitas_com(banco, id_ingrediente, &ids) > 0;
+}
+
+/* Insere uma receita com o id informado no ultimo slot liberado (ou no fim do array) */
+static int inserir_receita(BancoReceitas* banco, int id, const char* nome, const char* preparo) {
+    int slot;
+    if (banco->qtd_livres > 0) {
+        slot = banco->livres[banco->qtd_livres - 1];
+    } else {
+        if (!ensure_capacity(banco)) return 0;
+        slot = banco->qtd_slots;
+    }
 
     Receita* nova = (Receita*) malloc(sizeof(Receita));
     if (!nova) return 0;
 
-    nova->id = banco->prox_id++;
-    nova->nome = utl_strdup(nome);
-    nova->modo_preparo = utl_strdup(preparo ? preparo : "");
-    nova->ingredientes = NULL; // Inicializa a lista encadeada vazia
+    nova->id = id;
+    nova->nome = copiar_texto(banco, nome);
+    nova->modo_preparo = copiar_texto(banco, preparo ? preparo : "");
+    ing_inicializar(&nova->ingredientes); // Vetor de ingredientes vazio
 
-    if (!nova->nome || !nova->modo_preparo) {
-        free(nova->nome);
-        free(nova->modo_preparo);
+    if (!nova->nome || !nova->modo_preparo || !hsh_inserir(&banco->por_id, id, slot)) {
+        soltar_texto(banco, nova->nome);
+        soltar_texto(banco, nova->modo_preparo);
         free(nova);
         return 0;
     }
 
-    banco->vetor[banco->qtd_atual] = nova;
+    if (slot == banco->qtd_slots) banco->geracoes[banco->qtd_slots++] = 0;
+    else                          banco->qtd_livres--;
+    banco->vetor[slot] = nova;
     banco->qtd_atual++;
+    banco->versao++;
     return nova->id;
 }
 
-/* Buscar por ID: Retorna o ponteiro para a receita ou NULL se nao encontrar */
+/* Cadastrar: Cria uma nova receita e adiciona ao banco */
+int rec_cadastrar(BancoReceitas* banco, const char* nome, const char* preparo) {
+    if (!banco || !nome) return 0;
+    int id = inserir_receita(banco, banco->prox_id, nome, preparo);
+    if (id) banco->prox_id++;
+    return id;
+}
+
+/* Cadastra mantendo o id vindo do arquivo; recusa id repetido e ajusta prox_id */
+int rec_cadastrar_com_id(BancoReceitas* banco, int id, const char* nome, const char* preparo) {
+    if (!banco || !nome || rec_buscar_id(banco, id)) return 0;
+    if (!inserir_receita(banco, id, nome, preparo)) return 0;
+    if (id >= banco->prox_id) banco->prox_id = id + 1;
+    return id;
+}
+
+/* Buscar por ID: consulta o indice hash id -> posicao (O(1) em media). NULL se nao encontrar */
 Receita* rec_buscar_id(const BancoReceitas* banco, int id) {
     if (!banco) return NULL;
-    for (int i = 0; i < banco->qtd_atual; i++) {
-        if (banco->vetor[i]->id == id) {
-            return banco->vetor[i];
-        }
+    int idx = hsh_buscar(&banco->por_id, id);
+    return idx == -1 ? NULL : banco->vetor[idx];
+}
+
+Referencia rec_referencia(const BancoReceitas* banco, int id) {
+    Referencia ref = { -1, 0 };
+    int idx = banco ? hsh_buscar(&banco->por_id, id) : -1;
+    if (idx != -1) {
+        ref.slot = idx;
+        ref.geracao = banco->geracoes[idx];
     }
-    return NULL;
+    return ref;
+}
+
+/* Lapide ou geracao diferente: a receita referenciada nao existe mais */
+Receita* rec_resolver(const BancoReceitas* banco, Referencia ref) {
+    if (!banco || ref.slot < 0 || ref.slot >= banco->qtd_slots) return NULL;
+    if (banco->geracoes[ref.slot] != ref.geracao) return NULL;
+    return banco->vetor[ref.slot];
 }
 
 /* Listar: Percorre o banco e chama a listagem de ingredientes de cada receita */
 void rec_listar(const BancoReceitas* banco, const CatalogoIngredientes* cat) {
     if (!banco) return;
     printf("\n--- BANCO DE RECEITAS (%d receitas) ---\n", banco->qtd_atual);
-    for (int i = 0; i < banco->qtd_atual; i++) {
+    for (int i = 0; i < banco->qtd_slots; i++) {
         Receita* r = banco->vetor[i];
+        if (!r) continue;
         printf("ID: %d | Nome: %s\n", r->id, r->nome);
         printf("Modo de Preparo: %s\n", r->modo_preparo);
         // Chama a funcao do modulo de ingredientes
-        ing_listar(r->ingredientes, cat);
+        ing_listar(&r->ingredientes, cat);
         printf("----------------------------------------\n");
     }
 }
 
-/* Remover: Organiza o array e libera a lista encadeada e strings internas */
+/* Remover: libera o vetor de ingredientes e strings internas e deixa lapide no slot */
 int rec_remover(BancoReceitas* banco, int id) {
     if (!banco) return 0;
-    int idx = -1;
-    for (int i = 0; i < banco->qtd_atual; i++) {
-        if (banco->vetor[i]->id == id) {
-            idx = i;
-            break;
-        }
-    }
+    int idx = hsh_buscar(&banco->por_id, id);
     if (idx == -1) return 0;
 
     Receita* r = banco->vetor[idx];
-    free(r->nome);
-    free(r->modo_preparo);
-    ing_liberar_lista(&r->ingredientes);
+    for (int k = 0; k < r->ingredientes.qtd; k++)
+        desregistrar_uso(banco, r->ingredientes.itens[k].id_ingrediente, id);
+    soltar_texto(banco, r->nome);
+    soltar_texto(banco, r->modo_preparo);
+    ing_liberar(&r->ingredientes);
     free(r);
+    hsh_remover(&banco->por_id, id);
 
-    // Shift para fechar o buraco no array (compactacao)
-    for (int j = idx; j < banco->qtd_atual - 1; j++) {
-        banco->vetor[j] = banco->vetor[j + 1];
-    }
+    // Sem compactacao: ninguem muda de posicao; referencias antigas ao slot ficam invalidas
+    banco->vetor[idx] = NULL;
+    banco->geracoes[idx]++;
+    banco->livres[banco->qtd_livres++] = idx;
     banco->qtd_atual--;
+    banco->versao++;
     return 1;
 }
 
@@ -114,9 +261,9 @@ int rec_remover(BancoReceitas* banco, int id) {
 int rec_editar_nome(BancoReceitas* banco, int id, const char* novo_nome) {
     Receita* r = rec_buscar_id(banco, id);
     if (!r || !novo_nome) return 0;
-    char* n = utl_strdup(novo_nome);
+    char* n = copiar_texto(banco, novo_nome);
     if (!n) return 0;
-    free(r->nome);
+    soltar_texto(banco, r->nome);
     r->nome = n;
     return 1;
 }
@@ -125,18 +272,25 @@ int rec_editar_nome(BancoReceitas* banco, int id, const char* novo_nome) {
 int rec_editar_preparo(BancoReceitas* banco, int id, const char* novo_preparo) {
     Receita* r = rec_buscar_id(banco, id);
     if (!r || !novo_preparo) return 0;
-    char* p = utl_strdup(novo_preparo);
+    char* p = copiar_texto(banco, novo_preparo);
     if (!p) return 0;
-    free(r->modo_preparo);
+    soltar_texto(banco, r->modo_preparo);
     r->modo_preparo = p;
     return 1;
 }
 
 /* Adiciona um ingrediente a uma receita (usando o ID do catalogo) */
-int rec_add_ingrediente(BancoReceitas* banco, int id_receita, int id_ingrediente, float qtd) {
+int rec_add_ingrediente(BancoReceitas* banco, int id_receita, int id_ingrediente, Quantidade qtd) {
     Receita* r = rec_buscar_id(banco, id_receita);
     if (!r) return 0;
-    ing_adicionar(&r->ingredientes, id_ingrediente, qtd);
+    /* Registra no indice invertido antes: se faltar memoria, nada muda */
+    if (!registrar_uso(banco, id_ingrediente, id_receita)) return 0;
+    if (!ing_adicionar(&r->ingredientes, id_ingrediente, qtd)) {
+        if (!ing_buscar(&r->ingredientes, id_ingrediente))
+            desregistrar_uso(banco, id_ingrediente, id_receita);
+        return 0;
+    }
+    banco->versao++;
     return 1;
 }
 
@@ -144,19 +298,45 @@ int rec_add_ingrediente(BancoReceitas* banco, int id_receita, int id_ingrediente
 int rec_rem_ingrediente(BancoReceitas* banco, int id_receita, int id_ingrediente) {
     Receita* r = rec_buscar_id(banco, id_receita);
     if (!r) return 0;
-    return ing_remover(&r->ingredientes, id_ingrediente);
+    if (!ing_remover(&r->ingredientes, id_ingrediente)) return 0;
+    desregistrar_uso(banco, id_ingrediente, id_receita);
+    banco->versao++;
+    return 1;
+}
+
+/* Copia nome e modo de preparo das receitas vivas para 'destino'; no erro
+   de memoria para no meio, com os textos divididos entre as duas arenas */
+int rec_recopiar_textos(BancoReceitas* banco, ArenaStrings* destino) {
+    if (!banco || !banco->arena || !destino) return 0;
+    for (int i = 0; i < banco->qtd_slots; i++) {
+        Receita* r = banco->vetor[i];
+        if (!r) continue;
+        char* n = arena_internar(destino, r->nome);
+        char* p = arena_internar(destino, r->modo_preparo);
+        if (!n || !p) return 0;
+        r->nome = n;
+        r->modo_preparo = p;
+    }
+    return 1;
 }
 
 /* Liberar Memoria Total do banco e de todas as receitas */
 void rec_liberar_tudo(BancoReceitas* banco) {
     if (!banco) return;
-    for (int i = 0; i < banco->qtd_atual; i++) {
+    for (int i = 0; i < banco->qtd_slots; i++) {
         Receita* r = banco->vetor[i];
-        free(r->nome);
-        free(r->modo_preparo);
-        ing_liberar_lista(&r->ingredientes);
+        if (!r) continue;
+        soltar_texto(banco, r->nome);
+        soltar_texto(banco, r->modo_preparo);
+        ing_liberar(&r->ingredientes);
         free(r);
     }
     free(banco->vetor);
+    free(banco->geracoes);
+    free(banco->livres);
+    hsh_liberar(&banco->por_id);
+    for (int i = 0; i < banco->qtd_usos; i++) free(banco->usos[i].receitas);
+    free(banco->usos);
+    hsh_liberar(&banco->uso_por_ingrediente);
     free(banco);
 }
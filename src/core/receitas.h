@@ -2,30 +2,63 @@
 #define RECEITAS_H
 
 #include "ingredientes.h"
+#include "hash.h"
+#include "referencia.h"
+#include "arena.h"
 
 typedef struct {
     int id;
-    char* nome;
+    char* nome;             // da arena do banco (so leitura) ou alocado sem arena
     char* modo_preparo;
-    NoIngrediente* ingredientes; // Cabeça da lista encadeada
+    VetorIngredientes ingredientes; // Ordenado por id do ingrediente
 } Receita;
 
+/* Receitas que usam um ingrediente (ids em ordem crescente) */
+typedef struct {
+    int* receitas;
+    int qtd;
+    int capacidade;
+} UsoIngrediente;
+
+/*
+ * rec_remover deixa lapide (vetor[slot] == NULL) em vez de compactar: a
+ * geracao do slot sobe e ele e reaproveitado pela proxima receita. Para
+ * percorrer, va ate qtd_slots pulando os NULL.
+ */
 typedef struct {
     Receita** vetor;
-    int qtd_atual;
+    unsigned* geracoes;   // geracao de cada slot (ver Referencia)
+    int qtd_atual;        // receitas vivas
+    int qtd_slots;        // posicoes ja usadas em vetor (vivas ou lapides)
     int capacidade;
+    int* livres;          // pilha de slots com lapide, reaproveitados primeiro
+    int qtd_livres;
     int prox_id;
+    unsigned long versao; // muda a cada receita/ingrediente incluido ou removido
+    ArenaStrings* arena;  // de onde vem nome/modo_preparo (NULL = utl_strdup)
+    IndiceHash por_id;    // id -> posicao em vetor (busca O(1))
+
+    /* Indice invertido: id_ingrediente -> posicao em usos (a entrada fica, mesmo vazia) */
+    IndiceHash uso_por_ingrediente;
+    UsoIngrediente* usos;
+    int qtd_usos;
+    int cap_usos;
 } BancoReceitas;
 
-// Inicializa o banco (Array Dinamico)
-BancoReceitas* rec_inicializar();
+// Inicializa o banco (Array Dinamico). arena pode ser NULL
+BancoReceitas* rec_inicializar(ArenaStrings* arena);
 
 // Libera memoria total
 void rec_liberar_tudo(BancoReceitas* banco);
 
 // CRUD e operacoes de receitas
 int rec_cadastrar(BancoReceitas* banco, const char* nome, const char* preparo);
+int rec_cadastrar_com_id(BancoReceitas* banco, int id, const char* nome, const char* preparo); // carga de arquivo
 Receita* rec_buscar_id(const BancoReceitas* banco, int id);
+// Referencia estavel (slot -1 se o id nao existe); rec_resolver da NULL
+// se a receita foi removida desde entao
+Referencia rec_referencia(const BancoReceitas* banco, int id);
+Receita* rec_resolver(const BancoReceitas* banco, Referencia ref);
 int rec_remover(BancoReceitas* banco, int id);
 
 // Listagem e edicao
@@ -33,8 +66,18 @@ void rec_listar(const BancoReceitas* banco, const CatalogoIngredientes* cat);
 int rec_editar_nome(BancoReceitas* banco, int id, const char* novo_nome);
 int rec_editar_preparo(BancoReceitas* banco, int id, const char* novo_preparo);
 
+// Copia os textos das receitas vivas para 'destino' (compactacao da arena; so
+// com arena). Retorna 1 sucesso, 0 falha (ver app_compactar_textos)
+int rec_recopiar_textos(BancoReceitas* banco, ArenaStrings* destino);
+
 // Gerencia ingredientes dentro da receita
-int rec_add_ingrediente(BancoReceitas* banco, int id_receita, int id_ingrediente, float qtd);
+int rec_add_ingrediente(BancoReceitas* banco, int id_receita, int id_ingrediente, Quantidade qtd);
 int rec_rem_ingrediente(BancoReceitas* banco, int id_receita, int id_ingrediente);
 
+// Indice invertido: ids (crescentes) das receitas que usam o ingrediente.
+// Retorna a quantidade; *ids aponta para dentro do banco (vale ate a proxima mudanca)
+int rec_receitas_com(const BancoReceitas* banco, int id_ingrediente, const int** ids);
+// 1 se alguma receita usa o ingrediente
+int rec_ingrediente_em_uso(const BancoReceitas* banco, int id_ingrediente);
+
 #endif
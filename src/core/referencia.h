@@ -0,0 +1,20 @@
+#ifndef REFERENCIA_H
+#define REFERENCIA_H
+
+/*
+ * Referencia estavel a um item de catalogo, estoque ou banco de receitas.
+ *
+ * Esses arrays nao compactam mais na remocao: a posicao (slot) vira lapide,
+ * a geracao do slot sobe e o slot entra na lista de livres para ser
+ * reaproveitado. Quem guardou (slot, geracao) percebe que o item saiu ou foi
+ * trocado comparando a geracao, sem seguir ponteiro pendurado.
+ *
+ * Cada modulo resolve as suas: cat_resolver, est_resolver, rec_resolver
+ * (NULL se a referencia esta velha). slot -1 = referencia nula.
+ */
+typedef struct {
+    int slot;
+    unsigned geracao;
+} Referencia;
+
+#endif
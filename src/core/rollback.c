@@ -3,18 +3,20 @@
 #include "estoque.h"
 
 /* Inicializa a pilha */
-PilhaRollback* rb_criar() {
+PilhaRollback* rb_criar(PoolFixo* pool) {
     PilhaRollback* rb = (PilhaRollback*) malloc(sizeof(PilhaRollback));
     if (rb) {
         rb->topo = NULL;
+        rb->pool = pool;
     }
     return rb;
 }
 
 /* Adiciona um item no topo da pilha */
-void rb_push(PilhaRollback* rb, int id_ingrediente, float qtd) {
+void rb_push(PilhaRollback* rb, int id_ingrediente, Quantidade qtd) {
     if (!rb) return;
-    NoRollback* novo = (NoRollback*) malloc(sizeof(NoRollback));
+    NoRollback* novo = rb->pool ? (NoRollback*) pool_alocar(rb->pool)
+                                : (NoRollback*) malloc(sizeof(NoRollback));
     if (novo) {
         novo->id_ingrediente = id_ingrediente;
         novo->qtd = qtd;
@@ -24,13 +26,14 @@ void rb_push(PilhaRollback* rb, int id_ingrediente, float qtd) {
 }
 
 /* Remove e retorna o item do topo */
-int rb_pop(PilhaRollback* rb, int* out_id, float* out_qtd) {
+int rb_pop(PilhaRollback* rb, int* out_id, Quantidade* out_qtd) {
     if (!rb || !rb->topo) return 0;
     NoRollback* aux = rb->topo;
     if (out_id) *out_id = aux->id_ingrediente;
     if (out_qtd) *out_qtd = aux->qtd;
     rb->topo = aux->abaixo;
-    free(aux);
+    if (rb->pool) pool_devolver(rb->pool, aux);
+    else          free(aux);
     return 1;
 }
 
@@ -38,7 +41,7 @@ int rb_pop(PilhaRollback* rb, int* out_id, float* out_qtd) {
 void rb_desfazer(PilhaRollback* pilha, Estoque* est) {
     if (!pilha || !est) return;
     int id;
-    float qtd;
+    Quantidade qtd;
     while (rb_pop(pilha, &id, &qtd)) {
         est_adicionar(est, id, qtd);
     }
@@ -48,7 +51,7 @@ void rb_desfazer(PilhaRollback* pilha, Estoque* est) {
 void rb_limpar(PilhaRollback* rb) {
     if (!rb) return;
     int id;
-    float qtd;
+    Quantidade qtd;
     while (rb_pop(rb, &id, &qtd));
 }
 
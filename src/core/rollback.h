@@ -2,6 +2,7 @@
 #define ROLLBACK_H
 
 #include "estoque.h"
+#include "pool.h"
 
 /* 
  * Estrutura do Nó da Pilha de Rollback.
@@ -9,19 +10,21 @@
  */
 typedef struct NoRollback {
     int id_ingrediente;
-    float qtd;
+    Quantidade qtd;
     struct NoRollback* abaixo;
 } NoRollback;
 
 typedef struct {
     NoRollback* topo;
+    PoolFixo* pool;     // de onde vem os nos (NULL = malloc)
 } PilhaRollback;
 
-PilhaRollback* rb_criar();
+/* A pilha pode ser reaproveitada entre pedidos: rb_pop/rb_limpar a deixam vazia */
+PilhaRollback* rb_criar(PoolFixo* pool);
 void rb_liberar(PilhaRollback* rb);
 
-void rb_push(PilhaRollback* rb, int id_ingrediente, float qtd);
-int  rb_pop(PilhaRollback* rb, int* out_id, float* out_qtd);
+void rb_push(PilhaRollback* rb, int id_ingrediente, Quantidade qtd);
+int  rb_pop(PilhaRollback* rb, int* out_id, Quantidade* out_qtd);
 void rb_limpar(PilhaRollback* rb);
 
 /* 
@@ -1,6 +1,7 @@
 #include "utils.h"
 #include <stdlib.h>
 #include <string.h>
+#include <ctype.h>
 
 char* utl_strdup(const char* s) {
     if (!s) return NULL;
@@ -23,3 +24,13 @@ void utl_chomp(char* s) {
 int utl_str_not_empty(const char* s) {
     return (s && s[0] != '\0');
 }
+
+/* Copia alocada de s com letras ASCII em minusculas (bytes UTF-8 ficam iguais) */
+char* utl_str_minusculas(const char* s) {
+    char* copia = utl_strdup(s);
+    if (!copia) return NULL;
+    for (char* p = copia; *p; p++) {
+        *p = (char)tolower((unsigned char)*p);
+    }
+    return copia;
+}
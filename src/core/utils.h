@@ -4,5 +4,6 @@
 char* utl_strdup(const char* s);
 void  utl_chomp(char* s);
 int   utl_str_not_empty(const char* s);
+char* utl_str_minusculas(const char* s);
 
 #endif
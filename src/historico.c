@@ -0,0 +1,52 @@
+#define _POSIX_C_SOURCE 200809L
+#include "historico.h"
+#include <time.h>
+#ifdef _WIN32
+#include <process.h>
+#define pid_atual _getpid
+#else
+#include <unistd.h>
+#define pid_atual getpid
+#endif
+
+void hist_inicializar(Historico *h) {
+    h->inicio = 0;
+    h->qtd = 0;
+    h->rev = (long long)time(NULL) * 1000;
+    h->rev_minima = h->rev;
+    /* Abaixo de 2^53, para o JavaScript ler o numero sem arredondar */
+    h->epoca = (long long)time(NULL) * 100000 + (long long)(pid_atual() % 100000);
+}
+
+void hist_registrar(Historico *h, HistColecao colecao, int id, HistTipo tipo) {
+    HistMudanca *m;
+    if (h->qtd < HIST_CAPACIDADE) {
+        m = &h->itens[(h->inicio + h->qtd) % HIST_CAPACIDADE];
+        h->qtd++;
+    } else {
+        /* Buffer cheio: sobrescreve o mais antigo e o log deixa de cobri-lo */
+        m = &h->itens[h->inicio];
+        h->rev_minima = m->rev;
+        h->inicio = (h->inicio + 1) % HIST_CAPACIDADE;
+    }
+    m->rev = ++h->rev;
+    m->id = id;
+    m->colecao = (unsigned char)colecao;
+    m->tipo = (unsigned char)tipo;
+}
+
+void hist_invalidar(Historico *h) {
+    h->inicio = 0;
+    h->qtd = 0;
+    h->rev++;
+    h->rev_minima = h->rev;
+}
+
+int hist_cobre(const Historico *h, long long epoca, long long rev) {
+    return epoca == h->epoca && rev >= h->rev_minima && rev <= h->rev;
+}
+
+const HistMudanca *hist_registro(const Historico *h, size_t i) {
+    if (i >= h->qtd) return NULL;
+    return &h->itens[(h->inicio + i) % HIST_CAPACIDADE];
+}
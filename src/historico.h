@@ -0,0 +1,65 @@
+#ifndef HISTORICO_H
+#define HISTORICO_H
+
+#include <stddef.h>
+
+/*
+ * Registro de mudancas para sincronizacao incremental (GET_SINCE).
+ *
+ * Cada mutacao gera uma nova revisao (contador crescente) e um registro
+ * (colecao, id, tipo) num buffer circular de tamanho fixo. Um cliente que
+ * conhece a revisao R pede so o que mudou depois dela; se os registros
+ * de R em diante ja foram sobrescritos, ele precisa de um snapshot completo.
+ */
+
+#define HIST_CAPACIDADE 1024
+
+typedef enum {
+    HIST_CATALOGO = 0,
+    HIST_ESTOQUE,
+    HIST_RECEITAS,
+    HIST_PEDIDOS,
+    HIST_NUM_COLECOES
+} HistColecao;
+
+typedef enum {
+    HIST_INSERIU = 0,
+    HIST_ALTEROU,
+    HIST_REMOVEU
+} HistTipo;
+
+typedef struct {
+    long long rev;
+    int id;
+    unsigned char colecao;  // HistColecao
+    unsigned char tipo;     // HistTipo
+} HistMudanca;
+
+typedef struct {
+    HistMudanca itens[HIST_CAPACIDADE];
+    size_t inicio;          // posicao do registro mais antigo
+    size_t qtd;
+    long long rev;          // revisao atual (a da ultima mudanca)
+    long long rev_minima;   // menor revisao a partir da qual o log esta completo
+    long long epoca;        // identifica a execucao do processo (ver hist_cobre)
+} Historico;
+
+// Comeca um historico vazio. A revisao parte do horario atual e a epoca
+// junta horario e pid: uma revisao de outra execucao nao e aceita
+void hist_inicializar(Historico *h);
+
+// Registra uma mudanca com uma nova revisao
+void hist_registrar(Historico *h, HistColecao colecao, int id, HistTipo tipo);
+
+// Descarta o log (ex: estado recarregado do disco): todo cliente recebe snapshot
+void hist_invalidar(Historico *h);
+
+// 1 se 'rev' e desta execucao (mesma epoca) e as mudancas posteriores a
+// ela ainda estao todas no log. So a revisao nao basta: a execucao anterior
+// pode ter feito mais mudancas do que o relogio andou ate esta comecar
+int hist_cobre(const Historico *h, long long epoca, long long rev);
+
+// i-esimo registro (0 = mais antigo) entre os que estao no log
+const HistMudanca *hist_registro(const Historico *h, size_t i);
+
+#endif
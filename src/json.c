@@ -0,0 +1,164 @@
+#include "json.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+void json_iniciar(JsonWriter *w) {
+    memset(w, 0, sizeof(*w));
+}
+
+void json_liberar(JsonWriter *w) {
+    free(w->dados);
+    json_iniciar(w);
+}
+
+void json_limpar(JsonWriter *w) {
+    w->tam = 0;
+    w->prof = 0;
+    w->tem_elemento[0] = 0;
+    w->apos_chave = 0;
+    w->erro = 0;
+}
+
+/* Garante espaço para mais n bytes (dobrando a capacidade) */
+static int reservar(JsonWriter *w, size_t n) {
+    if (w->tam + n <= w->cap) return 1;
+    size_t nova = w->cap ? w->cap * 2 : 4096;
+    while (nova < w->tam + n) nova *= 2;
+    char *novo = realloc(w->dados, nova);
+    if (!novo) {
+        w->erro = 1;
+        return 0;
+    }
+    w->dados = novo;
+    w->cap = nova;
+    return 1;
+}
+
+void json_bruto(JsonWriter *w, const void *p, size_t n) {
+    if (!reservar(w, n)) return;
+    memcpy(w->dados + w->tam, p, n);
+    w->tam += n;
+}
+
+static void put(JsonWriter *w, char c) {
+    if (w->tam < w->cap || reservar(w, 1)) w->dados[w->tam++] = c;
+}
+
+/* Vírgula automática: antes de todo valor que não é o primeiro do container */
+static void antes_valor(JsonWriter *w) {
+    if (w->apos_chave) {
+        w->apos_chave = 0;
+        return;
+    }
+    if (w->tem_elemento[w->prof]) put(w, ',');
+    w->tem_elemento[w->prof] = 1;
+}
+
+static void abrir(JsonWriter *w, char c) {
+    antes_valor(w);
+    put(w, c);
+    if (w->prof + 1 < JSON_MAX_PROFUNDIDADE) w->prof++;
+    else w->erro = 1;
+    w->tem_elemento[w->prof] = 0;
+}
+
+static void fechar(JsonWriter *w, char c) {
+    put(w, c);
+    if (w->prof > 0) w->prof--;
+}
+
+void json_abrir_objeto(JsonWriter *w) { abrir(w, '{'); }
+void json_fechar_objeto(JsonWriter *w) { fechar(w, '}'); }
+void json_abrir_array(JsonWriter *w)  { abrir(w, '['); }
+void json_fechar_array(JsonWriter *w) { fechar(w, ']'); }
+
+/* Escreve a string entre aspas com escapes JSON (controles viram \uXXXX) */
+static void escrever_escapado(JsonWriter *w, const char *s) {
+    static const char hex[] = "0123456789abcdef";
+    put(w, '"');
+    if (s) {
+        const char *ini = s;   /* trecho sem escapes copiado de uma vez */
+        for (; *s; s++) {
+            unsigned char c = (unsigned char)*s;
+            if (c >= 0x20 && c != '"' && c != '\\') continue;
+            json_bruto(w, ini, (size_t)(s - ini));
+            ini = s + 1;
+            if (c == '"' || c == '\\') {
+                put(w, '\\');
+                put(w, (char)c);
+            } else if (c == '\n') {
+                json_bruto(w, "\\n", 2);
+            } else if (c == '\t') {
+                json_bruto(w, "\\t", 2);
+            } else if (c == '\r') {
+                json_bruto(w, "\\r", 2);
+            } else {
+                char u[6] = { '\\', 'u', '0', '0', hex[c >> 4], hex[c & 15] };
+                json_bruto(w, u, sizeof(u));
+            }
+        }
+        json_bruto(w, ini, (size_t)(s - ini));
+    }
+    put(w, '"');
+}
+
+void json_chave(JsonWriter *w, const char *chave) {
+    antes_valor(w);
+    escrever_escapado(w, chave);
+    put(w, ':');
+    w->apos_chave = 1;
+}
+
+void json_str(JsonWriter *w, const char *s) {
+    antes_valor(w);
+    escrever_escapado(w, s);
+}
+
+void json_int(JsonWriter *w, long long v) {
+    char buf[24];
+    int i = sizeof(buf);
+    unsigned long long u = v < 0 ? 0ULL - (unsigned long long)v : (unsigned long long)v;
+    do {
+        buf[--i] = (char)('0' + u % 10);
+        u /= 10;
+    } while (u);
+    if (v < 0) buf[--i] = '-';
+    antes_valor(w);
+    json_bruto(w, buf + i, sizeof(buf) - (size_t)i);
+}
+
+void json_num(JsonWriter *w, double v, int casas) {
+    char buf[64];
+    if (!isfinite(v)) v = 0; /* JSON não tem NaN/Infinity */
+    int n = snprintf(buf, sizeof(buf), "%.*f", casas, v);
+    antes_valor(w);
+    if (n > 0) json_bruto(w, buf, (size_t)n < sizeof(buf) ? (size_t)n : sizeof(buf) - 1);
+}
+
+void json_bool(JsonWriter *w, int v) {
+    antes_valor(w);
+    if (v) json_bruto(w, "true", 4);
+    else json_bruto(w, "false", 5);
+}
+
+void json_campo_str(JsonWriter *w, const char *chave, const char *s) {
+    json_chave(w, chave);
+    json_str(w, s);
+}
+
+void json_campo_int(JsonWriter *w, const char *chave, long long v) {
+    json_chave(w, chave);
+    json_int(w, v);
+}
+
+void json_campo_num(JsonWriter *w, const char *chave, double v, int casas) {
+    json_chave(w, chave);
+    json_num(w, v, casas);
+}
+
+void json_campo_bool(JsonWriter *w, const char *chave, int v) {
+    json_chave(w, chave);
+    json_bool(w, v);
+}
@@ -0,0 +1,51 @@
+#ifndef JSON_H
+#define JSON_H
+
+#include <stddef.h>
+
+/*
+ * Escritor de JSON sobre um buffer crescente.
+ *
+ * As virgulas entre elementos sao colocadas automaticamente: basta abrir
+ * objetos/arrays, escrever chaves e valores na ordem. Nada vai para o
+ * stdout aqui — quem usa decide quando enviar o buffer (uma escrita so).
+ */
+
+#define JSON_MAX_PROFUNDIDADE 32
+
+typedef struct {
+    char *dados;
+    size_t tam;
+    size_t cap;
+    int prof;                               // nivel de aninhamento atual
+    int tem_elemento[JSON_MAX_PROFUNDIDADE]; // 1 se o container ja tem algum valor
+    int apos_chave;                         // proximo valor completa um "chave":
+    int erro;                               // 1 se alguma alocacao falhou
+} JsonWriter;
+
+void json_iniciar(JsonWriter *w);
+void json_liberar(JsonWriter *w);
+// Esvazia o buffer (mantem a memoria) para montar a proxima resposta
+void json_limpar(JsonWriter *w);
+
+void json_abrir_objeto(JsonWriter *w);
+void json_fechar_objeto(JsonWriter *w);
+void json_abrir_array(JsonWriter *w);
+void json_fechar_array(JsonWriter *w);
+void json_chave(JsonWriter *w, const char *chave);
+
+void json_str(JsonWriter *w, const char *s);     // NULL vira ""
+void json_int(JsonWriter *w, long long v);
+void json_num(JsonWriter *w, double v, int casas); // ponto fixo, ex: casas=2 -> 1.50
+void json_bool(JsonWriter *w, int v);
+
+// Atalhos "chave": valor dentro de objetos
+void json_campo_str(JsonWriter *w, const char *chave, const char *s);
+void json_campo_int(JsonWriter *w, const char *chave, long long v);
+void json_campo_num(JsonWriter *w, const char *chave, double v, int casas);
+void json_campo_bool(JsonWriter *w, const char *chave, int v);
+
+// Bytes crus no buffer, fora da estrutura JSON (ex: cabecalho de frame, '\n')
+void json_bruto(JsonWriter *w, const void *p, size_t n);
+
+#endif
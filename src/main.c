@@ -11,20 +11,18 @@ int main() {
         return 1;
     }
 
-    // Carrega dados existentes
-    pers_carregar_catalogo(app->cat);
-    pers_carregar_receitas(app->banco);
-    pers_carregar_estoque(app->estoque);
-    pers_carregar_pedidos(app->fila, app->banco);
+    // Carrega dados existentes (snapshot + journal)
+    pers_carregar_tudo(app->cat, app->banco, app->estoque, app->fila);
+
+    // Pedidos estacionados (opcao 4 da tela de pedidos) voltam quando o estoque chega
+    if (!ped_ligar_espera(app->fila, app->estoque))
+        printf("Aviso: fila de espera por ingrediente indisponivel.\n");
 
     // Inicia o loop da interface
     ui_loop(app);
 
-    // Salva antes de sair
-    pers_salvar_catalogo(app->cat);
-    pers_salvar_receitas(app->banco);
-    pers_salvar_estoque(app->estoque);
-    pers_salvar_pedidos(app->fila);
+    // Salva antes de sair (snapshots completos + journal vazio)
+    pers_compactar(app->cat, app->banco, app->estoque, app->fila);
 
     // Destroi e libera memoria
     app_destruir(app);
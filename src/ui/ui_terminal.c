@@ -9,6 +9,15 @@ static void limpar_buffer() {
     while ((c = getchar()) != '\n' && c != EOF);
 }
 
+/* Le a quantidade como texto e converte para milesimos (texto invalido = 0) */
+static Quantidade ler_quantidade() {
+    char txt[QTD_TEXTO_MAX];
+    Quantidade q;
+    if (scanf("%31s", txt) != 1 || !qtd_ler(txt, &q)) q = 0;
+    limpar_buffer();
+    return q;
+}
+
 void ui_loop(AppContext* app) {
     int opcao = -1;
     while (opcao != 0) {
@@ -82,7 +91,8 @@ void ui_tela_catalogo(AppContext* app) {
             case 4:
                 printf("ID do ingrediente para remover: ");
                 scanf("%d", &id); limpar_buffer();
-                if (cat_remover(app->cat, id)) printf("Removido com sucesso.\n");
+                if (rec_ingrediente_em_uso(app->banco, id)) printf("Ingrediente usado em receita. Remova das receitas primeiro.\n");
+                else if (cat_remover(app->cat, id)) printf("Removido com sucesso.\n");
                 else printf("ID nao encontrado ou em uso.\n");
                 break;
         }
@@ -103,7 +113,7 @@ void ui_tela_estoque(AppContext* app) {
         limpar_buffer();
 
         int id;
-        float qtd;
+        Quantidade qtd;
 
         switch (sub) {
             case 1:
@@ -114,7 +124,7 @@ void ui_tela_estoque(AppContext* app) {
                 printf("Selecione o ID do ingrediente: ");
                 scanf("%d", &id);
                 printf("Quantidade a adicionar: ");
-                scanf("%f", &qtd); limpar_buffer();
+                qtd = ler_quantidade();
                 est_adicionar(app->estoque, id, qtd);
                 printf("Estoque atualizado.\n");
                 break;
@@ -123,7 +133,7 @@ void ui_tela_estoque(AppContext* app) {
                 printf("ID do ingrediente: ");
                 scanf("%d", &id);
                 printf("Quantidade a retirar: ");
-                scanf("%f", &qtd); limpar_buffer();
+                qtd = ler_quantidade();
                 if (est_remover(app->estoque, id, qtd)) printf("Retirada realizada.\n");
                 else printf("Falha: Quantidade insuficiente ou ID inexistente.\n");
                 break;
@@ -147,7 +157,7 @@ void ui_tela_receitas(AppContext* app) {
 
         char nome[100], preparo[500];
         int id_rec, id_ing;
-        float qtd;
+        Quantidade qtd;
 
         switch (sub) {
             case 1:
@@ -169,15 +179,20 @@ void ui_tela_receitas(AppContext* app) {
                 printf("ID do Ingrediente: ");
                 scanf("%d", &id_ing);
                 printf("Quantidade necessaria: ");
-                scanf("%f", &qtd); limpar_buffer();
-                if (rec_add_ingrediente(app->banco, id_rec, id_ing, qtd))
+                qtd = ler_quantidade();
+                if (rec_add_ingrediente(app->banco, id_rec, id_ing, qtd)) {
                     printf("Ingrediente adicionado a receita.\n");
+                    // O que os pedidos estacionados esperam pode ter mudado
+                    ped_desbloquear_todos(app->fila);
+                }
                 else printf("Erro: Receita nao encontrada.\n");
                 break;
             case 4:
                 printf("ID da receita para remover: ");
                 scanf("%d", &id_rec); limpar_buffer();
-                if (rec_remover(app->banco, id_rec)) printf("Receita excluida.\n");
+                if (ped_pedidos_da_receita(app->fila, id_rec) > 0)
+                    printf("Erro: Ha pedidos na fila com esta receita.\n");
+                else if (rec_remover(app->banco, id_rec)) printf("Receita excluida.\n");
                 else printf("Receita nao encontrada.\n");
                 break;
         }
@@ -192,6 +207,7 @@ void ui_tela_pedidos(AppContext* app) {
         printf("1. Listar pedidos pendentes\n");
         printf("2. Novo pedido (Enfileirar)\n");
         printf("3. Processar proximo pedido (Cozinhar)\n");
+        printf("4. Processar o proximo que der para fazer (estaciona os sem estoque)\n");
         printf("0. Voltar\n");
         printf("Opcao: ");
         scanf("%d", &sub);
@@ -214,9 +230,9 @@ void ui_tela_pedidos(AppContext* app) {
                 } else printf("Receita nao encontrada.\n");
                 break;
             case 3:
-                if (ped_processar_proximo(app->fila, app->estoque)) {
-                    // Mensagem de sucesso ja impressa pela funcao core
-                }
+            case 4:
+                // Mensagens de sucesso/falha ja impressas pela funcao core
+                ped_processar_proximo(app->fila, app->estoque, app->rollback, sub == 4);
                 break;
         }
     }